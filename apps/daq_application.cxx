@@ -86,6 +86,14 @@ main(int argc, char* argv[])
 			  args.command_facility_plugin_name,
 			  args.conf_service_plugin_name);
 
+  app.set_warm_restart(args.warm_restart);
+  app.set_incremental_reconf(args.incremental_reconf);
+  app.set_command_queue_depth(args.command_queue_depth);
+  app.set_history_dump_path(args.history_file);
+  app.set_command_recording(args.record_file);
+  app.set_trace_file(args.trace_file);
+  app.set_command_data_service(args.command_data_service);
+  app.set_command_cancellation(std::chrono::milliseconds(args.command_timeout_ms), args.fail_fast);
   app.init();
   app.run(run_marker);
 
@@ -0,0 +1,145 @@
+/**
+ * @file CancellationToken.hpp Cooperative cancellation of module commands
+ *
+ * A CancellationSource is owned by whoever may want a piece of work to give up early (DAQModuleManager for the
+ * execution of a command), the work itself only sees CancellationTokens. Like std::stop_token, cancellation is
+ * cooperative: a token never interrupts anything by itself, the work checks stop_requested() or waits on it, for
+ * example with Interruptible::interruptible_wait.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_CANCELLATIONTOKEN_HPP_
+#define APPFWK_INCLUDE_APPFWK_CANCELLATIONTOKEN_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace dunedaq {
+namespace appfwk {
+
+namespace detail {
+struct CancellationState
+{
+  std::atomic<bool> requested{ false };
+  std::mutex mutex; // protects reason and callbacks
+  std::string reason;
+  std::map<uint64_t, std::function<void()>> callbacks;
+  uint64_t next_callback_id{ 0 };
+};
+} // namespace detail
+
+class CancellationToken
+{
+public:
+  /// A token which is never cancelled
+  CancellationToken() = default;
+
+  bool stop_possible() const { return m_state != nullptr; }
+  bool stop_requested() const { return m_state != nullptr && m_state->requested.load(std::memory_order_acquire); }
+
+  /// Why the cancellation was requested, empty if it was not
+  std::string reason() const
+  {
+    if (!stop_requested())
+      return "";
+    const std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->reason;
+  }
+
+private:
+  friend class CancellationSource;
+  friend class CancellationCallback;
+
+  explicit CancellationToken(std::shared_ptr<detail::CancellationState> state)
+    : m_state(std::move(state))
+  {
+  }
+
+  std::shared_ptr<detail::CancellationState> m_state;
+};
+
+class CancellationSource
+{
+public:
+  CancellationSource()
+    : m_state(std::make_shared<detail::CancellationState>())
+  {
+  }
+
+  CancellationToken token() const { return CancellationToken(m_state); }
+  bool stop_requested() const { return m_state->requested.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Cancel the tokens of this source and run their callbacks
+   * @returns false if the cancellation had already been requested, in which case the first reason is kept
+   */
+  bool request_stop(const std::string& reason)
+  {
+    const std::lock_guard<std::mutex> lock(m_state->mutex);
+    if (m_state->requested.load(std::memory_order_relaxed))
+      return false;
+    m_state->reason = reason;
+    m_state->requested.store(true, std::memory_order_release);
+    for (auto& [id, callback] : m_state->callbacks)
+      callback();
+    return true;
+  }
+
+private:
+  std::shared_ptr<detail::CancellationState> m_state;
+};
+
+/**
+ * @brief Runs a callback when a token is cancelled, for as long as the CancellationCallback exists
+ *
+ * Like std::stop_callback, the callback runs immediately if the token is already cancelled, otherwise in the
+ * thread calling request_stop. The callback must be short and must not create or destroy CancellationCallbacks of
+ * the same token; the destructor waits for a running callback to finish.
+ */
+class CancellationCallback
+{
+public:
+  CancellationCallback(const CancellationToken& token, std::function<void()> callback)
+    : m_state(token.m_state)
+  {
+    if (m_state == nullptr)
+      return;
+    const std::lock_guard<std::mutex> lock(m_state->mutex);
+    if (m_state->requested.load(std::memory_order_relaxed)) {
+      callback();
+      m_state = nullptr;
+      return;
+    }
+    m_id = m_state->next_callback_id++;
+    m_state->callbacks.emplace(m_id, std::move(callback));
+  }
+
+  ~CancellationCallback()
+  {
+    if (m_state == nullptr)
+      return;
+    const std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->callbacks.erase(m_id);
+  }
+
+  CancellationCallback(const CancellationCallback&) = delete;
+  CancellationCallback& operator=(const CancellationCallback&) = delete;
+
+private:
+  std::shared_ptr<detail::CancellationState> m_state;
+  uint64_t m_id{ 0 };
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_INCLUDE_APPFWK_CANCELLATIONTOKEN_HPP_
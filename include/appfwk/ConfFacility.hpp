@@ -10,10 +10,23 @@
 
 #include "Issues.hpp"
 
+#include "appfwk/opmon/conf_facility.pb.h"
+#include "opmonlib/MonitorableObject.hpp"
+
 #include <cetlib/BasicPluginFactory.h>
 #include <cetlib/compiler_macros.h>
 #include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #ifndef EXTERN_C_FUNC_DECLARE_START
 #define EXTERN_C_FUNC_DECLARE_START                                                                                    \
@@ -37,8 +50,10 @@ namespace dunedaq::appfwk {
 
 /**
  * @brief Interface needed by DAQ apps and services for configuration handling
+ *
+ * Registered as an opmon node, a facility keeping a cache publishes its CacheCounters as ConfCacheInfo.
  */
-class ConfFacility
+class ConfFacility : public opmonlib::MonitorableObject
 {
 public:
   explicit ConfFacility(std::string /*uri*/) {}
@@ -50,7 +65,183 @@ public:
 
   virtual nlohmann::json get_data(const std::string& app_name, const std::string& cmd, const std::string& uri) = 0;
 
+  /**
+   * @brief Counters of the local cache of previous responses kept by some facilities
+   */
+  struct CacheCounters
+  {
+    uint64_t hits = 0;          ///< Responses served from the cache after a successful revalidation
+    uint64_t misses = 0;        ///< Responses downloaded in full from the service
+    uint64_t revalidations = 0; ///< Conditional requests sent for an already cached response
+    uint64_t stale_hits = 0;    ///< Responses served from the cache without a usable answer from the service
+  };
+
+  virtual CacheCounters get_cache_counters() const { return CacheCounters(); }
+
+  /**
+   * @brief Retrieve the data for a command without blocking the caller
+   *
+   * The default implementation runs get_data on a separate thread. Facilities should override it with an
+   * implementation that does not consume the results of prefetch().
+   */
+  virtual std::future<nlohmann::json> get_data_async(const std::string& app_name,
+                                                     const std::string& cmd,
+                                                     const std::string& uri = "")
+  {
+    return std::async(std::launch::async, [this, app_name, cmd, uri]() { return get_data(app_name, cmd, uri); });
+  }
+
+  /**
+   * @brief Start retrieving the data for the given commands ahead of time
+   *
+   * Meant to be called while the application is idle, with the commands of the transitions it can take next. A
+   * later get_data for the same application, command and resolved URI returns the prefetched data instead of
+   * issuing a new request, as long as it was prefetched in the current generation and less than the prefetch TTL
+   * ago. Commands that are already being prefetched are skipped.
+   */
+  void prefetch(const std::string& app_name, const std::vector<std::string>& cmds, const std::string& uri = "")
+  {
+    auto resolved = resolve_uri(uri);
+    auto now = std::chrono::steady_clock::now();
+    const std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    prune_retired();
+    for (const auto& cmd : cmds) {
+      auto key = std::make_tuple(app_name, cmd, resolved);
+      auto it = m_prefetched.find(key);
+      if (it != m_prefetched.end()) {
+        if (!is_stale(it->second, now))
+          continue;
+        m_retired.push_back(std::move(it->second.data));
+        m_prefetched.erase(it);
+      }
+      m_prefetched.emplace(key, Prefetched{ get_data_async(app_name, cmd, resolved).share(), now, m_generation });
+    }
+  }
+
+  /**
+   * @brief Start a new generation of prefetched data
+   *
+   * Data prefetched until now is not handed over anymore, e.g. because the configuration it was retrieved for has
+   * been replaced.
+   */
+  void invalidate_prefetched()
+  {
+    const std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    ++m_generation;
+    for (auto& [key, prefetched] : m_prefetched)
+      m_retired.push_back(std::move(prefetched.data));
+    m_prefetched.clear();
+    prune_retired();
+  }
+
+  /**
+   * @brief Age after which prefetched data is not handed over anymore and is retrieved again
+   */
+  void set_prefetch_ttl(std::chrono::milliseconds ttl)
+  {
+    const std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    m_prefetch_ttl = ttl;
+  }
+
+protected:
+  /**
+   * @brief The URI a request with the given one goes to
+   *
+   * Facilities remember the URI of their last request and use it when get_data is given an empty one. Prefetched
+   * data is keyed on the resolved URI, so that it is only handed over while the facility still points to the same
+   * place.
+   */
+  virtual std::string resolve_uri(const std::string& uri) { return uri; }
+
+  void generate_opmon_data() override
+  {
+    auto counters = get_cache_counters();
+    if (counters.hits + counters.misses + counters.revalidations + counters.stale_hits == 0)
+      return;
+    opmon::ConfCacheInfo info;
+    info.set_hits(counters.hits);
+    info.set_misses(counters.misses);
+    info.set_revalidations(counters.revalidations);
+    info.set_stale_hits(counters.stale_hits);
+    publish(std::move(info));
+  }
+
+  /**
+   * @brief Hand over the result of a previous prefetch(), if any
+   *
+   * Waits for the prefetch to complete if it is still in flight. A failed prefetch is discarded, so that the caller
+   * can retry the retrieval synchronously and report the error itself, and so is one from a previous generation or
+   * older than the prefetch TTL.
+   */
+  std::optional<nlohmann::json> take_prefetched(const std::string& app_name,
+                                                const std::string& cmd,
+                                                const std::string& uri)
+  {
+    std::shared_future<nlohmann::json> prefetched;
+    {
+      const std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+      auto it = m_prefetched.find(std::make_tuple(app_name, cmd, resolve_uri(uri)));
+      if (it == m_prefetched.end())
+        return std::nullopt;
+      auto stale = is_stale(it->second, std::chrono::steady_clock::now());
+      prefetched = std::move(it->second.data);
+      m_prefetched.erase(it);
+      if (stale) {
+        m_retired.push_back(std::move(prefetched));
+        return std::nullopt;
+      }
+    }
+    try {
+      return prefetched.get();
+    } catch (const std::exception&) {
+      return std::nullopt;
+    }
+  }
+
+  /**
+   * @brief Wait for all outstanding prefetches to complete
+   *
+   * Facilities whose get_data_async runs their own member functions must call this in their destructor.
+   */
+  void wait_prefetched()
+  {
+    const std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    for (auto& [key, prefetched] : m_prefetched)
+      prefetched.data.wait();
+    for (auto& retired : m_retired)
+      retired.wait();
+  }
+
 private:
+  struct Prefetched
+  {
+    std::shared_future<nlohmann::json> data;
+    std::chrono::steady_clock::time_point requested;
+    uint64_t generation;
+  };
+
+  bool is_stale(const Prefetched& prefetched, std::chrono::steady_clock::time_point now) const
+  {
+    return prefetched.generation != m_generation || now - prefetched.requested > m_prefetch_ttl;
+  }
+
+  // The last reference to the result of std::async blocks until the retrieval completes, so discarded prefetches
+  // still in flight are only released once they are done, never while holding m_prefetch_mutex
+  void prune_retired()
+  {
+    m_retired.erase(std::remove_if(m_retired.begin(),
+                                   m_retired.end(),
+                                   [](const std::shared_future<nlohmann::json>& retired) {
+                                     return retired.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                   }),
+                    m_retired.end());
+  }
+
+  std::mutex m_prefetch_mutex;
+  std::map<std::tuple<std::string, std::string, std::string>, Prefetched> m_prefetched;
+  std::vector<std::shared_future<nlohmann::json>> m_retired;
+  uint64_t m_generation = 0;
+  std::chrono::milliseconds m_prefetch_ttl = std::chrono::seconds(60);
 };
 
 std::shared_ptr<ConfFacility>
@@ -42,6 +42,7 @@ public:
 
   const confmodel::Session* session() { return m_session; }
   const confmodel::Application* application() { return m_application; }
+  conffwk::Configuration& confdb() { return *m_confdb; }
   template<typename T>
   const T* get_dal(const std::string& name)
   {
@@ -19,7 +19,10 @@
 #ifndef APPFWK_INCLUDE_APPFWK_DAQMODULE_HPP_
 #define APPFWK_INCLUDE_APPFWK_DAQMODULE_HPP_
 
+#include "appfwk/CancellationToken.hpp"
 #include "appfwk/ModuleConfiguration.hpp"
+#include "appfwk/ModuleThread.hpp"
+#include "appfwk/TimerService.hpp"
 
 #include "utilities/NamedObject.hpp"
 #include "opmonlib/MonitorableObject.hpp"
@@ -29,9 +32,11 @@
 #include "ers/Issue.hpp"
 #include "nlohmann/json.hpp"
 
+#include <chrono>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -146,6 +151,17 @@ ERS_DECLARE_ISSUE_BASE(appfwk,                        ///< Namespace
                        ((std::string)type)((std::string)direction)           ///< Attribute of this class
 )
 
+/**
+ * @brief The ThreadRegistrationFailed DAQModule ERS Issue
+ */
+ERS_DECLARE_ISSUE_BASE(appfwk,                                              ///< Namespace
+                       ThreadRegistrationFailed,                            ///< Type of the Issue
+                       appfwk::GeneralDAQModuleIssue,                       ///< Base class of the Issue
+                       "Thread registration failed: " << thread << " exists", ///< Log Message from the issue
+                       ((std::string)name),                                 ///< Base class attributes
+                       ((std::string)thread)                                ///< Attribute of this class
+)
+
 // Re-enable coverage collection LCOV_EXCL_STOP
 namespace appfwk {
 
@@ -175,9 +191,9 @@ public:
   }
 
   /**
-   * @brief DAQModule destructor
+   * @brief DAQModule destructor, cancels the timers of the module
    */
-  virtual ~DAQModule() noexcept = default;
+  virtual ~DAQModule() noexcept;
 
   /**
    * @brief      Initializes the module
@@ -197,13 +213,37 @@ public:
    * accepted commands to the appropriate functions within the DAQModule.
    *  Non-accepted commands or failure should return an ERS exception
    * indicating this result.
+   *
+   * The token is passed on to the handlers registered with a CancellationToken parameter, it is cancelled when the
+   * framework wants the command to give up (timeout, another module failing, explicit abort).
+   *
+   * The threads registered with register_thread are stopped before the handler of their stop command, and of
+   * scrap, and started after the handler of their start command. The timers of the module are cancelled before
+   * the handler of scrap.
    */
-  void execute_command(const std::string& name, const data_t& data = {});
+  void execute_command(const std::string& name,
+                       const data_t& data = {},
+                       const CancellationToken& token = CancellationToken());
 
   std::vector<std::string> get_commands() const;
 
   bool has_command(const std::string& name) const;
 
+  /**
+   * @brief Stops the threads registered with register_thread and cancels the timers of the module
+   *
+   * The DAQModuleManager calls it before it re-initialises or releases a module, so that no managed thread or timer
+   * callback runs while the module is re-initialised or its derived class destroyed, whether or not the module
+   * handles scrap.
+   */
+  void stop_threads_and_timers() noexcept;
+
+  /// Names, as given to register_thread, of the registered threads which are running
+  std::vector<std::string> running_threads() const;
+
+  /// Starts registered threads again, e.g. those that were running before the module was reconfigured
+  void start_threads(const std::vector<std::string>& names);
+
 protected:
   /**
    * @brief Registers a mdoule command under the name `cmd`.
@@ -212,14 +252,87 @@ protected:
   template<typename Child>
   void register_command(const std::string& name, void (Child::*f)(const data_t&));
 
+  /**
+   * @brief Registers a module command whose handler receives the cancellation token of the command execution
+   *
+   * Handlers which wait or loop for a long time should check the token, or wait with the Interruptible helpers
+   * taking it, and return early when it is cancelled.
+   */
+  template<typename Child>
+  void register_command(const std::string& name, void (Child::*f)(const data_t&, const CancellationToken&));
+
+  /**
+   * @brief Registers a worker thread managed by the framework, calling `iteration` in a loop while it runs
+   *
+   * The thread is started after the handler of `start_cmd` and stopped before the handler of `stop_cmd`, which do
+   * not need to be registered as commands otherwise. It is named after the module, restricted to the cores given
+   * to ModuleThread::set_affinity (typically from the module configuration, in init) and its usage is published as
+   * an opmon child of the module named `name`.
+   *
+   * A thread may be registered in init: registering it again under the same name and commands, when a warm restart
+   * or an incremental reconfiguration initialises the module again, replaces its iteration function and keeps its
+   * affinity and usage counters. Registering a name again with other commands, or while its thread runs, throws
+   * ThreadRegistrationFailed.
+   *
+   * Modules destroyed by the DAQModuleManager have their threads stopped first, see stop_threads_and_timers. Threads
+   * of modules destroyed otherwise are only stopped by the DAQModule destructor, after the derived class is
+   * destroyed.
+   */
+  ModuleThread& register_thread(const std::string& name,
+                                ModuleThread::iteration_t iteration,
+                                const std::string& start_cmd = "start",
+                                const std::string& stop_cmd = "stop");
+
+  template<typename Child>
+  ModuleThread& register_thread(const std::string& name,
+                                bool (Child::*f)(),
+                                const std::string& start_cmd = "start",
+                                const std::string& stop_cmd = "stop");
+
+  /**
+   * @brief Runs callback every period on the TimerService of the application, instead of a dedicated thread
+   *
+   * The timer is named `<module>/<name>` in the opmon data of the TimerService. Callbacks run on a shared thread
+   * pool and must be short. Timers are cancelled by cancel_timer, before the handler of scrap and by
+   * stop_threads_and_timers, like threads.
+   */
+  TimerService::timer_id_t schedule_periodic(const std::string& name,
+                                             std::chrono::milliseconds period,
+                                             TimerService::callback_t callback);
+
+  /// Runs callback once after delay on the TimerService of the application, see schedule_periodic
+  TimerService::timer_id_t schedule_once(const std::string& name,
+                                         std::chrono::milliseconds delay,
+                                         TimerService::callback_t callback);
+
+  /// Cancels a timer of the module and waits for its callback if it is running, see TimerService::cancel
+  bool cancel_timer(TimerService::timer_id_t id);
+
   DAQModule(DAQModule const&) = delete;
   DAQModule(DAQModule&&) = delete;
   DAQModule& operator=(DAQModule const&) = delete;
   DAQModule& operator=(DAQModule&&) = delete;
 
 private:
-  using CommandMap_t = std::map<std::string, std::function<void(const data_t&)>>;
+  using CommandMap_t = std::map<std::string, std::function<void(const data_t&, const CancellationToken&)>>;
   CommandMap_t m_commands;
+
+  struct ManagedThread
+  {
+    std::string name;
+    std::shared_ptr<ModuleThread> thread;
+    std::string start_cmd;
+    std::string stop_cmd;
+  };
+  std::vector<ManagedThread> m_threads;
+
+  TimerService& timer_service();
+  TimerService::timer_id_t add_timer(TimerService::timer_id_t id);
+  void cancel_timers();
+
+  std::mutex m_timers_mutex; // timers can be scheduled from any thread
+  std::shared_ptr<TimerService> m_timer_service;
+  std::vector<TimerService::timer_id_t> m_timers;
 };
 
 /**
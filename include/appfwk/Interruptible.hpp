@@ -13,26 +13,38 @@
 #ifndef APPFWK_INCLUDE_APPFWK_INTERRUPTIBLE_HPP_
 #define APPFWK_INCLUDE_APPFWK_INTERRUPTIBLE_HPP_
 
+#include "appfwk/CancellationToken.hpp"
+#include "appfwk/detail/CpuRelax.hpp"
+
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 namespace dunedaq {
 namespace appfwk {
+
+/// Whether T can be passed as a condition to Interruptible::interruptible_wait_any
+template<typename T>
+constexpr bool is_wait_condition_v = std::is_same_v<std::remove_cv_t<std::remove_reference_t<T>>, std::atomic<bool>> ||
+                                     std::is_invocable_r_v<bool, std::remove_reference_t<T>&>;
+
 class Interruptible
 {
 public:
-  Interruptible()
-    : m_wait_cv()
-    , m_wait_mutex()
-  {
-  }
+  Interruptible() = default;
 
   /**
    * @brief Interruptible destructor
    */
   virtual ~Interruptible() noexcept = default;
 
+  Interruptible(const Interruptible&) = delete;
+  Interruptible& operator=(const Interruptible&) = delete;
+
   /**
    * @brief Send a notification that an interrupt is requested.
    *
@@ -46,13 +58,10 @@ public:
    *
    * Note that there is minimal penalty for calling interrupt_self() when no threads are waiting, so it can
    * be called multiple times in succession, for example by a "stop" command handler and then by
-   * execute_command.
+   * execute_command. It takes no lock: it bumps a generation counter, and only enters the kernel to wake
+   * waiters if some are blocked.
    */
-  void interrupt_self()
-  {
-    std::unique_lock<std::mutex> wait_lock(m_wait_mutex);
-    m_wait_cv.notify_all();
-  }
+  void interrupt_self();
 
 protected:
   /**
@@ -71,20 +80,87 @@ protected:
    */
   bool interruptible_wait(std::chrono::microseconds wait_duration,
                           std::atomic<bool>& wait_condition,
-                          bool direction = false)
-  {
-    std::unique_lock<std::mutex> wait_lock(m_wait_mutex);
+                          bool direction = false);
 
-    // Wait Predicate should return false to continue wait
-    return m_wait_cv.wait_for(wait_lock, wait_duration, [&]() { return wait_condition.load() != direction; });
-  }
+  /**
+   * @brief Same as interruptible_wait, but until an absolute steady_clock deadline
+   *
+   * Loops that wait repeatedly for the same period should use a deadline advanced by the period each time, so
+   * that the time spent between waits does not accumulate.
+   */
+  bool interruptible_wait_until(std::chrono::steady_clock::time_point deadline,
+                                std::atomic<bool>& wait_condition,
+                                bool direction = false);
+
+  /**
+   * @brief Sleep until one of several conditions holds, or until the deadline
+   * @param deadline steady_clock time at which the wait gives up
+   * @param conditions Each one either a std::atomic<bool>, which holds when true, or a callable returning bool
+   * @returns The index of the first condition (in argument order) that holds, or std::nullopt at the deadline
+   *
+   * The conditions are evaluated when the wait starts and after every interrupt, so whoever changes the state a
+   * condition depends on (stopping the run, filling a buffer, ...) must call interrupt_self() afterwards, as for
+   * interruptible_wait. A predicate must therefore be cheap and must not block.
+   */
+  template<typename... Conditions, typename = std::enable_if_t<(is_wait_condition_v<Conditions> && ...)>>
+  std::optional<size_t> interruptible_wait_any(std::chrono::steady_clock::time_point deadline,
+                                               Conditions&&... conditions);
+
+  /// interruptible_wait_any with a timeout relative to now
+  template<typename... Conditions>
+  std::optional<size_t> interruptible_wait_any_for(std::chrono::microseconds wait_duration,
+                                                   Conditions&&... conditions);
+
+  /// interruptible_wait_any for a list of predicates only known at run time
+  std::optional<size_t> interruptible_wait_any(std::chrono::steady_clock::time_point deadline,
+                                               const std::vector<std::function<bool()>>& conditions);
+
+  /**
+   * @brief interruptible_wait which also ends as soon as the token is cancelled
+   * @returns The result of wait_condition after the sleep, token.stop_requested() tells if the token ended it
+   *
+   * Command handlers registered with a CancellationToken use it so that an aborted or timed out command releases
+   * its thread without waiting for the full wait_duration.
+   */
+  bool interruptible_wait(std::chrono::microseconds wait_duration,
+                          std::atomic<bool>& wait_condition,
+                          const CancellationToken& token,
+                          bool direction = false);
+
+  /**
+   * @brief interruptible_wait_any which also ends as soon as the token is cancelled
+   * @returns 0 if the token was cancelled, i + 1 if the i-th condition holds, std::nullopt at the deadline
+   */
+  template<typename... Conditions>
+  std::optional<size_t> cancellable_wait_any(const CancellationToken& token,
+                                             std::chrono::steady_clock::time_point deadline,
+                                             Conditions&&... conditions);
+
+  /**
+   * @brief Busy-wait for up to spin_duration before blocking in interruptible_wait
+   *
+   * Blocking waits are woken by the kernel scheduler, which typically takes tens of microseconds and more on a
+   * loaded machine. Latency-critical modules can spin for a bounded time first, at the cost of one busy core
+   * while they wait. The default, zero, blocks immediately.
+   */
+  void set_wait_spin(std::chrono::nanoseconds spin_duration) { m_spin_duration = spin_duration; }
 
 private:
-  // For interruptible waits
-  std::condition_variable m_wait_cv;
-  std::mutex m_wait_mutex;
+  // Waits until check returns a value or the deadline passes, re-evaluating check after every interrupt
+  template<typename Check>
+  std::optional<size_t> wait_until(std::chrono::steady_clock::time_point deadline, Check&& check);
+
+  // Blocks until m_generation differs from generation, the thread is woken or the deadline passes
+  void block(uint32_t generation, std::chrono::steady_clock::time_point deadline);
+
+  // Incremented by every interrupt, waiters sleep on it with a futex
+  std::atomic<uint32_t> m_generation{ 0 };
+  std::atomic<uint32_t> m_blocked_waiters{ 0 };
+  std::chrono::nanoseconds m_spin_duration{ 0 };
 };
 } // namespace appfwk
 } // namespace dunedaq
 
+#include "detail/Interruptible.hxx"
+
 #endif // APPFWK_INCLUDE_APPFWK_INTERRUPTIBLE_HPP_
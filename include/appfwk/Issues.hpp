@@ -14,6 +14,7 @@
 
 #include "ers/ers.hpp"
 
+#include <cstdint>
 #include <string>
 
 namespace dunedaq {
@@ -56,6 +57,17 @@ ERS_DECLARE_ISSUE(appfwk, InvalidConfigurationURI, "Cannot get a configuration u
 
 ERS_DECLARE_ISSUE(appfwk, ConfigurationRetreival, "Failed to retrieve configuration: " << uri, ((std::string)uri))
 
+ERS_DECLARE_ISSUE(appfwk,
+                  ConfigurationCacheFailure,
+                  "Configuration cache in " << dir << " could not be used: " << reason,
+                  ((std::string)dir)((std::string)reason))
+
+ERS_DECLARE_ISSUE(appfwk,
+                  StaleConfigurationServed,
+                  "Configuration service gave no usable answer for " << uri << ", serving cached copy validated "
+                                                                     << age_s << " s ago",
+                  ((std::string)uri)((uint64_t)age_s)) // NOLINT
+
 ERS_DECLARE_ISSUE(appfwk,
                   ActionPlanNotFound,
                   "No action plan found for command " << cmd << ", taking the following action: " << message,
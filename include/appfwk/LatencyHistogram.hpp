@@ -0,0 +1,157 @@
+/**
+ * @file LatencyHistogram.hpp Fixed-memory, log-bucketed histogram of latencies, recorded lock-free from any thread
+ *
+ * The buckets follow the HdrHistogram layout: values below 2^sub_bucket_bits are counted exactly, and every larger
+ * power of two range is split into 2^sub_bucket_bits linear sub-buckets, so that a value is known to within
+ * 1/2^sub_bucket_bits (6.25%) of itself whatever its magnitude. The whole 64 bit range fits in less than a thousand
+ * counters, allocated with the histogram. Recording a value is a few relaxed atomic increments and never blocks, so
+ * any number of threads can record into the same histogram; percentiles are computed when the counts are read.
+ *
+ * Percentiles are reported as the upper edge of the bucket containing them, capped by the largest value recorded.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_LATENCYHISTOGRAM_HPP_
+#define APPFWK_INCLUDE_APPFWK_LATENCYHISTOGRAM_HPP_
+
+#include "appfwk/TscClock.hpp"
+
+#include "opmonlib/MonitorableObject.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace dunedaq::appfwk {
+
+class LatencyHistogram
+{
+public:
+  static constexpr size_t sub_bucket_bits = 4;
+  static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+  static constexpr size_t n_buckets = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+  /// Counts of the histogram at one point in time
+  struct Snapshot
+  {
+    std::array<uint64_t, n_buckets> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+  };
+
+  /// Distribution of the values recorded, in the unit of the values
+  struct Summary
+  {
+    uint64_t count = 0;
+    double mean = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+  };
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  /// Records one value, from any thread
+  void record(uint64_t value) noexcept
+  {
+    m_counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    update_max(m_max, value);
+    update_max(m_interval_max, value);
+  }
+
+  /// Records a duration, in nanoseconds
+  template<typename Rep, typename Period>
+  void record(std::chrono::duration<Rep, Period> duration) noexcept
+  {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    record(static_cast<uint64_t>(ns > 0 ? ns : 0));
+  }
+
+  /// Records the time elapsed since start, a TscClock::now() timestamp, in nanoseconds
+  void record_since(TscClock::ticks_t start) noexcept
+  {
+    auto end = TscClock::now();
+    record(end > start ? TscClock::to_ns(end - start) : 0);
+  }
+
+  /// Current counts, since the histogram was created
+  Snapshot snapshot() const;
+
+  /// Distribution of all the values recorded since the histogram was created
+  Summary summary() const { return summarise(snapshot()); }
+
+  /**
+   * @brief Distribution of the values recorded after the earlier snapshot was taken
+   *
+   * The max of the result is the upper edge of the highest non-empty bucket, capped by the overall max.
+   */
+  Summary summary_since(const Snapshot& earlier) const;
+
+  /**
+   * @brief Distribution of the values recorded since the previous call, typically from generate_opmon_data
+   *
+   * Unlike summary_since, the max is exact. Values recorded concurrently with the call are counted in this interval
+   * or in the next one, none is lost.
+   */
+  Summary interval_summary();
+
+  /// Bucket counting value
+  static size_t bucket(uint64_t value) noexcept
+  {
+    if (value < sub_buckets)
+      return static_cast<size_t>(value);
+    size_t shift = 63 - __builtin_clzll(value) - sub_bucket_bits;
+    return ((shift + 1) << sub_bucket_bits) + static_cast<size_t>((value >> shift) - sub_buckets);
+  }
+
+  /// Largest value counted by bucket index
+  static uint64_t bucket_upper(size_t index) noexcept;
+
+private:
+  static void update_max(std::atomic<uint64_t>& max, uint64_t value) noexcept
+  {
+    auto current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  static Summary summarise(const Snapshot& snapshot);
+
+  std::array<std::atomic<uint64_t>, n_buckets> m_counts{};
+  std::atomic<uint64_t> m_sum{ 0 };
+  std::atomic<uint64_t> m_max{ 0 };
+  std::atomic<uint64_t> m_interval_max{ 0 }; // reset by interval_summary
+
+  std::mutex m_interval_mutex; // serialises the callers of interval_summary, the writers never take it
+  Snapshot m_interval_start;
+};
+
+/**
+ * @brief LatencyHistogram of durations in nanoseconds, publishing a LatencyHistogramInfo for every opmon interval
+ *
+ * A module registers it as one of its opmon nodes, e.g. register_node("latency", m_latency) with m_latency a
+ * std::shared_ptr<OpMonLatencyHistogram> member, and records durations into it from its threads.
+ */
+class OpMonLatencyHistogram
+  : public opmonlib::MonitorableObject
+  , public LatencyHistogram
+{
+protected:
+  void generate_opmon_data() override;
+};
+
+} // namespace dunedaq::appfwk
+
+#endif // APPFWK_INCLUDE_APPFWK_LATENCYHISTOGRAM_HPP_
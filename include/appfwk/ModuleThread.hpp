@@ -0,0 +1,146 @@
+/**
+ * @file ModuleThread.hpp Worker thread managed by the framework on behalf of a DAQModule
+ *
+ * A ModuleThread calls an iteration function in a loop, from the time it is started until it is stopped or the
+ * function returns false. It names its OS thread, places it on the configured cores and accounts for its CPU time,
+ * context switches and iterations, which it publishes as a ModuleThreadInfo opmon entry. DAQModules register their
+ * threads with DAQModule::register_thread, which starts and stops them with the module commands.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_MODULETHREAD_HPP_
+#define APPFWK_INCLUDE_APPFWK_MODULETHREAD_HPP_
+
+#include "opmonlib/MonitorableObject.hpp"
+#include "utilities/NamedObject.hpp"
+
+#include "ers/Issue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+
+// Disable coverage collection LCOV_EXCL_START
+/**
+ * @brief The ThreadAffinityFailed ERS Issue
+ */
+ERS_DECLARE_ISSUE(appfwk,                                                           ///< Namespace
+                  ThreadAffinityFailed,                                             ///< Issue class name
+                  "Cannot restrict thread " << thread << " to cores " << cpus << ": " << error, ///< Message
+                  ((std::string)thread)((std::string)cpus)((std::string)error)      ///< Message parameters
+)
+
+/**
+ * @brief The ModuleThreadFailed ERS Issue
+ */
+ERS_DECLARE_ISSUE(appfwk,                                                      ///< Namespace
+                  ModuleThreadFailed,                                          ///< Issue class name
+                  "Thread " << thread << " stopped on an exception: " << what, ///< Message
+                  ((std::string)thread)((std::string)what)                     ///< Message parameters
+)
+// Re-enable coverage collection LCOV_EXCL_STOP
+
+namespace appfwk {
+
+class ModuleThread
+  : public utilities::NamedObject
+  , public opmonlib::MonitorableObject
+{
+public:
+  /**
+   * @brief Body of the thread loop, returning false ends the thread
+   *
+   * The function must return regularly (e.g. receive with a timeout rather than block), since the thread can only
+   * be stopped and its usage accounted between two iterations.
+   */
+  using iteration_t = std::function<bool()>;
+
+  /**
+   * @param name Name of the thread. The OS thread is named after its last 15 characters, the kernel limit.
+   * @param iteration Function called in a loop while the thread runs
+   */
+  ModuleThread(const std::string& name, iteration_t iteration);
+
+  /// Stops the thread, the iteration function must still be callable until then
+  ~ModuleThread() noexcept;
+
+  ModuleThread(const ModuleThread&) = delete;
+  ModuleThread& operator=(const ModuleThread&) = delete;
+
+  /**
+   * @brief Restrict the thread to the given cores, an empty list removes the restriction
+   *
+   * The affinity is applied when the thread starts. A failure is reported as a ThreadAffinityFailed warning and the
+   * thread runs without restriction.
+   */
+  void set_affinity(const std::vector<int>& cpus);
+  std::vector<int> get_affinity() const;
+
+  /// Replaces the function called in a loop, joining the thread first if its iteration ended it. Must not be called
+  /// while the thread is running.
+  void set_iteration(iteration_t iteration);
+
+  /// Starts the thread, does nothing if it is already started
+  void start();
+
+  /// Asks the thread to stop after its current iteration and joins it, does nothing if it is not started
+  void stop();
+
+  /// Whether the thread was started and is still looping
+  bool running() const { return m_looping.load(std::memory_order_acquire); }
+
+  /// Number of iterations since the thread was first started
+  uint64_t iterations() const { return m_iterations.load(std::memory_order_relaxed); }
+
+protected:
+  void generate_opmon_data() override;
+
+private:
+  void run();
+  void sample_usage();
+
+  // How often the thread samples its resource usage between iterations
+  static constexpr std::chrono::milliseconds s_sample_period{ 100 };
+
+  iteration_t m_iteration;
+  std::thread m_thread;
+  std::atomic<bool> m_run_requested{ false };
+  std::atomic<bool> m_looping{ false };
+
+  mutable std::mutex m_affinity_mutex;
+  std::vector<int> m_affinity;
+
+  // Written by the thread only, cumulative over all the starts of the thread
+  std::atomic<uint64_t> m_iterations{ 0 };
+  std::atomic<uint64_t> m_user_ns{ 0 };
+  std::atomic<uint64_t> m_system_ns{ 0 };
+  std::atomic<uint64_t> m_voluntary_switches{ 0 };
+  std::atomic<uint64_t> m_involuntary_switches{ 0 };
+  std::atomic<int> m_cpu{ -1 };
+
+  // Usage of the previous OS threads, getrusage only accounts for the current one
+  uint64_t m_base_user_ns = 0;
+  uint64_t m_base_system_ns = 0;
+  uint64_t m_base_voluntary_switches = 0;
+  uint64_t m_base_involuntary_switches = 0;
+
+  // State of the previous opmon report, to compute rates
+  uint64_t m_reported_iterations = 0;
+  uint64_t m_reported_cpu_ns = 0;
+  std::chrono::steady_clock::time_point m_report_time = std::chrono::steady_clock::now();
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_INCLUDE_APPFWK_MODULETHREAD_HPP_
@@ -0,0 +1,132 @@
+/**
+ * @file OpMonSnapshot.hpp Seqlock-protected metrics, written by a data path thread and read by the opmon thread
+ *
+ * A module reporting a group of related counters (e.g. messages and bytes, or a sum and a count) from its
+ * generate_opmon_data either locks the data path while it copies them, or reads them one by one and reports values
+ * which do not belong together. An OpMonSnapshot keeps the metrics struct behind a sequence lock instead: the
+ * single writer never blocks nor waits, it only performs plain atomic stores, and readers retry until they copy a
+ * consistent version, which only happens if they race with an update of the few words of the struct.
+ *
+ * The struct must be trivially copyable. Its bytes are stored in relaxed atomic words, so that the concurrent
+ * reads and writes are not data races in the sense of the C++ memory model.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_OPMONSNAPSHOT_HPP_
+#define APPFWK_INCLUDE_APPFWK_OPMONSNAPSHOT_HPP_
+
+#include "appfwk/detail/CpuRelax.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace dunedaq::appfwk {
+
+template<typename T>
+class OpMonSnapshot
+{
+  static_assert(std::is_trivially_copyable_v<T>, "OpMonSnapshot requires a trivially copyable metrics struct");
+
+public:
+  OpMonSnapshot() { write_words(); }
+  explicit OpMonSnapshot(const T& initial)
+    : m_writer_copy(initial)
+  {
+    write_words();
+  }
+
+  OpMonSnapshot(const OpMonSnapshot&) = delete;
+  OpMonSnapshot& operator=(const OpMonSnapshot&) = delete;
+
+  /**
+   * @brief Modify the metrics and publish them, from the writer thread only
+   *
+   * modify is called on the writer's own copy, which no other thread reads, so it can update several fields with
+   * plain operations; the result is then published at once.
+   */
+  template<typename Modify>
+  void update(Modify&& modify) noexcept
+  {
+    modify(m_writer_copy);
+    publish();
+  }
+
+  /// Replace the metrics, from the writer thread only
+  void store(const T& value) noexcept
+  {
+    m_writer_copy = value;
+    publish();
+  }
+
+  /// Latest metrics as seen by the writer, from the writer thread only
+  const T& writer_view() const noexcept { return m_writer_copy; }
+
+  /// Consistent copy of the latest published metrics, from any thread
+  T load() const noexcept
+  {
+    T value;
+    while (!try_load(value)) {
+      detail::cpu_relax();
+    }
+    return value;
+  }
+
+  /// Single attempt at load, false if it raced with an update
+  bool try_load(T& value) const noexcept
+  {
+    auto before = m_sequence.load(std::memory_order_acquire);
+    if (before & 1)
+      return false;
+
+    std::array<uint64_t, s_words> words;
+    for (size_t i = 0; i < s_words; ++i)
+      words[i] = m_words[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_sequence.load(std::memory_order_relaxed) != before)
+      return false;
+
+    std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+    return true;
+  }
+
+  /// Number of updates published so far
+  uint64_t version() const noexcept { return m_sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+  static constexpr size_t s_words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  void publish() noexcept
+  {
+    // Odd sequence while the words are being written
+    auto sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    write_words();
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  void write_words() noexcept
+  {
+    std::array<uint64_t, s_words> words{};
+    std::memcpy(words.data(), &m_writer_copy, sizeof(T));
+    for (size_t i = 0; i < s_words; ++i)
+      m_words[i].store(words[i], std::memory_order_relaxed);
+  }
+
+  T m_writer_copy{};
+
+  // On their own cache line, so that readers do not disturb the writer's other data
+  alignas(64) std::atomic<uint64_t> m_sequence{ 0 };
+  std::array<std::atomic<uint64_t>, s_words> m_words{};
+};
+
+} // namespace dunedaq::appfwk
+
+#endif // APPFWK_INCLUDE_APPFWK_OPMONSNAPSHOT_HPP_
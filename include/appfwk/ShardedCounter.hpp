@@ -0,0 +1,138 @@
+/**
+ * @file ShardedCounter.hpp Counters and gauges updated from many threads without sharing a cache line
+ *
+ * A std::atomic counter incremented by several data path threads bounces its cache line between their cores on
+ * every increment, which limits the update rate of all of them to a few million per second. A ShardedCounter spreads
+ * the value over cells on separate cache lines: every thread updates the cell it is assigned to, so that threads on
+ * different cells never contend, and the cells are only summed when the value is read, typically by
+ * generate_opmon_data. A thread is assigned the lowest free cell index when it first updates a sharded counter and
+ * frees it when it exits, so a cell is only shared if more threads than cells are alive at the same time.
+ *
+ * OpMonCounters groups named counters and gauges and publishes them as opmon data, as a node of a module.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_SHARDEDCOUNTER_HPP_
+#define APPFWK_INCLUDE_APPFWK_SHARDEDCOUNTER_HPP_
+
+#include "opmonlib/MonitorableObject.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dunedaq::appfwk {
+
+namespace detail {
+
+/// Cell of a sharded value, alone on its cache line
+template<typename T>
+struct alignas(64) ShardCell
+{
+  std::atomic<T> value{ 0 };
+};
+
+/// Index of the calling thread, the lowest one not held by another thread at its first call
+size_t
+thread_shard_index() noexcept;
+
+/// Number of cells of the sharded values: the number of cores rounded up to a power of two, at most 64
+size_t
+default_shards() noexcept;
+
+template<typename T>
+class ShardedValue
+{
+public:
+  ShardedValue()
+    : m_mask(default_shards() - 1)
+    , m_cells(new ShardCell<T>[m_mask + 1])
+  {
+  }
+
+  ShardedValue(const ShardedValue&) = delete;
+  ShardedValue& operator=(const ShardedValue&) = delete;
+
+  /// Sum of the cells. Not a snapshot: updates made while the cells are read may or may not be included
+  T value() const noexcept
+  {
+    T sum = 0;
+    for (size_t i = 0; i <= m_mask; ++i)
+      sum += m_cells[i].value.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+protected:
+  void add(T delta) noexcept
+  {
+    m_cells[thread_shard_index() & m_mask].value.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+private:
+  const size_t m_mask;
+  std::unique_ptr<ShardCell<T>[]> m_cells;
+};
+
+} // namespace detail
+
+/// Monotonic counter, e.g. of messages or bytes
+class ShardedCounter : public detail::ShardedValue<uint64_t>
+{
+public:
+  void increment(uint64_t n = 1) noexcept { add(n); }
+};
+
+/// Value which goes up and down, e.g. the number of buffers in use
+class ShardedGauge : public detail::ShardedValue<int64_t>
+{
+public:
+  void increment(int64_t n = 1) noexcept { add(n); }
+  void decrement(int64_t n = 1) noexcept { add(-n); }
+};
+
+/**
+ * @brief Named ShardedCounters and ShardedGauges, published as opmon data
+ *
+ * A module registers it as one of its opmon nodes and creates its metrics once, e.g. in its constructor:
+ *
+ *     m_counters = std::make_shared<OpMonCounters>();
+ *     register_node("counters", m_counters);
+ *     m_received = &m_counters->counter("received_messages");
+ *
+ * Every report publishes a CounterInfo per counter, with its value and its rate since the previous report, and a
+ * GaugeInfo per gauge, with the metric name as "metric" custom origin.
+ */
+class OpMonCounters : public opmonlib::MonitorableObject
+{
+public:
+  /// The counter with this name, created if it does not exist. References stay valid as long as the object lives
+  ShardedCounter& counter(const std::string& name);
+  ShardedGauge& gauge(const std::string& name);
+
+protected:
+  void generate_opmon_data() override;
+
+private:
+  struct Counter
+  {
+    ShardedCounter counter;
+    uint64_t reported = 0;
+  };
+
+  std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<Counter>> m_counters;
+  std::map<std::string, std::unique_ptr<ShardedGauge>> m_gauges;
+  std::chrono::steady_clock::time_point m_report_time = std::chrono::steady_clock::now();
+};
+
+} // namespace dunedaq::appfwk
+
+#endif // APPFWK_INCLUDE_APPFWK_SHARDEDCOUNTER_HPP_
@@ -0,0 +1,185 @@
+/**
+ * @file TimerService.hpp Shared scheduler for the periodic and one-shot tasks of the DAQModules
+ *
+ * Instead of every module running a thread which sleeps until its next periodic publication or flush, modules
+ * register callbacks with the TimerService of the application. Timers are kept in a hierarchical timer wheel with a
+ * 1 ms tick (4 levels of 256 slots, covering delays of up to 49 days), so that scheduling, cancelling and expiring a
+ * timer take constant time whatever the number of timers. One thread advances the wheel, sleeping until the next
+ * occupied slot, and a small pool of threads runs the callbacks. The lateness of every callback with respect to
+ * its scheduled time is measured and published as opmon data.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_TIMERSERVICE_HPP_
+#define APPFWK_INCLUDE_APPFWK_TIMERSERVICE_HPP_
+
+#include "opmonlib/MonitorableObject.hpp"
+
+#include "ers/Issue.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+
+// Disable coverage collection LCOV_EXCL_START
+/**
+ * @brief The TimerCallbackFailed ERS Issue
+ */
+ERS_DECLARE_ISSUE(appfwk,                                                   ///< Namespace
+                  TimerCallbackFailed,                                      ///< Issue class name
+                  "Callback of timer " << timer << " failed: " << what,     ///< Message
+                  ((std::string)timer)((std::string)what)                   ///< Message parameters
+)
+// Re-enable coverage collection LCOV_EXCL_STOP
+
+namespace appfwk {
+
+class TimerService : public opmonlib::MonitorableObject
+{
+public:
+  using timer_id_t = uint64_t;
+  using callback_t = std::function<void()>;
+  using clock_t = std::chrono::steady_clock;
+
+  static constexpr std::chrono::milliseconds tick{ 1 };
+
+  /// Cumulative statistics of one timer
+  struct TimerStats
+  {
+    std::string name;
+    uint64_t runs;
+    uint64_t overruns; // occurrences skipped because the previous callback was still running or late
+    double mean_lateness_us;
+    double max_lateness_us;
+    double max_duration_us;
+  };
+
+  /// @param n_workers Number of threads running the callbacks
+  explicit TimerService(size_t n_workers = 2);
+
+  /// Stops the threads, the timers which did not fire are dropped
+  ~TimerService() noexcept;
+
+  TimerService(const TimerService&) = delete;
+  TimerService& operator=(const TimerService&) = delete;
+
+  /// Runs callback once, after delay (rounded up to the next tick boundary, so between delay and delay + 1 tick)
+  timer_id_t schedule_once(const std::string& name, std::chrono::milliseconds delay, callback_t callback);
+
+  /**
+   * @brief Runs callback every period, the first time after first_delay
+   *
+   * The schedule does not drift: the n-th run is due at first_delay + n * period. An occurrence due while the
+   * previous one is still waiting for a worker or running is skipped and counted as an overrun, so a callback is
+   * never run concurrently with itself and a late timer does not run in bursts to catch up.
+   */
+  timer_id_t schedule_periodic(const std::string& name,
+                               std::chrono::milliseconds period,
+                               callback_t callback,
+                               std::chrono::milliseconds first_delay);
+  timer_id_t schedule_periodic(const std::string& name, std::chrono::milliseconds period, callback_t callback)
+  {
+    return schedule_periodic(name, period, std::move(callback), period);
+  }
+
+  /**
+   * @brief Cancels a timer and waits for its callback to return if it is running
+   * @returns false if the timer does not exist (cancelled, or one-shot which already ran)
+   *
+   * A callback can cancel its own timer, in which case cancel does not wait.
+   */
+  bool cancel(timer_id_t id);
+
+  /// Whether the timer is scheduled (or is a one-shot timer whose callback did not complete yet)
+  bool scheduled(timer_id_t id) const;
+
+  size_t size() const;
+  std::vector<TimerStats> get_stats() const;
+
+protected:
+  void generate_opmon_data() override;
+
+private:
+  struct Timer
+  {
+    timer_id_t id;
+    std::string name;
+    callback_t callback;
+    uint64_t period_ticks; // 0 for one-shot timers
+
+    // Protected by m_mutex
+    uint64_t expiry_tick;
+    bool cancelled = false;
+    bool queued = false; // in m_ready
+    bool running = false;
+
+    // Written by the worker running the callback, read by the monitoring
+    std::atomic<uint64_t> runs{ 0 };
+    std::atomic<uint64_t> overruns{ 0 };
+    std::atomic<uint64_t> total_lateness_ns{ 0 };
+    std::atomic<uint64_t> max_lateness_ns{ 0 };
+    std::atomic<uint64_t> max_duration_ns{ 0 };
+    std::atomic<uint64_t> interval_max_lateness_ns{ 0 }; // reset at every opmon report
+  };
+  using TimerPtr = std::shared_ptr<Timer>;
+
+  static constexpr size_t s_slot_bits = 8;
+  static constexpr size_t s_slots = 1 << s_slot_bits;
+  static constexpr uint64_t s_slot_mask = s_slots - 1;
+  static constexpr size_t s_levels = 4;
+  static constexpr uint64_t s_max_delay_ticks = (uint64_t(1) << (s_slot_bits * s_levels)) - 1;
+
+  timer_id_t add(const std::string& name, uint64_t delay_ticks, uint64_t period_ticks, callback_t callback);
+  void insert(const TimerPtr& timer);
+  void advance(uint64_t tick);
+  uint64_t next_wake_tick() const;
+  uint64_t elapsed_ticks(clock_t::time_point time) const;
+  clock_t::time_point tick_time(uint64_t tick) const { return m_origin + tick * TimerService::tick; }
+
+  void run_wheel();
+  void run_worker();
+
+  const clock_t::time_point m_origin;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wheel_cv;
+  std::condition_variable m_work_cv;
+  std::condition_variable m_done_cv;
+  bool m_stopping = false;
+  bool m_wheel_changed = false;
+
+  uint64_t m_now_tick = 0; // last tick processed by the wheel
+  std::array<std::array<std::vector<TimerPtr>, s_slots>, s_levels> m_wheel;
+  std::array<uint64_t, s_slots / 64> m_level0_occupied{}; // bitmap of the non-empty slots of level 0
+  std::unordered_map<timer_id_t, TimerPtr> m_timers;
+  std::deque<std::pair<TimerPtr, uint64_t>> m_ready; // timers due, with the tick they were due at
+  timer_id_t m_next_id = 1;
+
+  std::thread m_wheel_thread;
+  std::vector<std::thread> m_workers;
+};
+
+/// The TimerService shared by the modules of the application
+std::shared_ptr<TimerService>
+get_timer_service();
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_INCLUDE_APPFWK_TIMERSERVICE_HPP_
@@ -0,0 +1,82 @@
+/**
+ * @file TscClock.hpp Cheap timestamps for instrumentation, from the CPU time stamp counter
+ *
+ * Reading std::chrono::steady_clock costs a vDSO call, tens of nanoseconds, and much more on virtual machines where
+ * the kernel falls back to a slower clock source. On x86 CPUs with an invariant TSC (constant rate in all power
+ * states, synchronised between cores), TscClock::now() reads the counter directly, in a few nanoseconds. Timestamps
+ * are raw ticks, converted to nanoseconds only when they are used: a tick rate is measured against steady_clock over
+ * 10 ms by calibrate(), or else at the first conversion, and refined over longer and longer intervals as conversions
+ * to steady_clock time are requested later on.
+ *
+ * On other CPUs, or if the APPFWK_DISABLE_TSC environment variable is set, ticks are steady_clock nanoseconds and
+ * the conversions are identities.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_TSCCLOCK_HPP_
+#define APPFWK_INCLUDE_APPFWK_TSCCLOCK_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace dunedaq::appfwk {
+
+class TscClock
+{
+public:
+  using ticks_t = uint64_t;
+
+  /// Current timestamp, in ticks
+  static ticks_t now() noexcept
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    if (uses_tsc())
+      return __rdtsc();
+#endif
+    return steady_ns();
+  }
+
+  /// Whether ticks come from the TSC, decided once per process
+  static bool uses_tsc() noexcept
+  {
+    static const bool use_tsc = detect_invariant_tsc();
+    return use_tsc;
+  }
+
+  /// Measure the tick rate now, so that the first conversion does not wait for it. Only the first call measures.
+  static void calibrate() noexcept;
+
+  /// Nanoseconds in a number of ticks, typically the difference of two timestamps
+  static uint64_t to_ns(ticks_t ticks) noexcept;
+  static std::chrono::nanoseconds to_duration(ticks_t ticks) noexcept
+  {
+    return std::chrono::nanoseconds(static_cast<int64_t>(to_ns(ticks)));
+  }
+
+  /// steady_clock time of a timestamp, in nanoseconds since the clock's epoch
+  static int64_t to_steady_ns(ticks_t timestamp) noexcept;
+
+  /// Current tick rate estimate, 1 without TSC
+  static double ticks_per_ns() noexcept;
+
+private:
+  static bool detect_invariant_tsc() noexcept;
+
+  static ticks_t steady_ns() noexcept
+  {
+    return static_cast<ticks_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count());
+  }
+};
+
+} // namespace dunedaq::appfwk
+
+#endif // APPFWK_INCLUDE_APPFWK_TSCCLOCK_HPP_
@@ -0,0 +1,27 @@
+/**
+ * @file CpuRelax.hpp Spin-wait hint shared by the busy-waiting loops of appfwk
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_DETAIL_CPURELAX_HPP_
+#define APPFWK_INCLUDE_APPFWK_DETAIL_CPURELAX_HPP_
+
+namespace dunedaq::appfwk::detail {
+
+/// Tell the CPU that the calling thread is spinning, and the compiler that memory may have changed
+inline void
+cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+} // namespace dunedaq::appfwk::detail
+
+#endif // APPFWK_INCLUDE_APPFWK_DETAIL_CPURELAX_HPP_
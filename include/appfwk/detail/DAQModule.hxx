@@ -14,4 +14,28 @@ DAQModule::register_command(const std::string& cmd_name,
   }
 }
 
+template<typename Child>
+void
+DAQModule::register_command(const std::string& cmd_name,
+                            void (Child::*f)(const data_t&, const CancellationToken&))
+{
+  using namespace std::placeholders;
+
+  bool done = m_commands.emplace(cmd_name, std::bind(f, dynamic_cast<Child*>(this), _1, _2)).second;
+  if (!done) {
+    // Throw here
+    throw CommandRegistrationFailed(ERS_HERE, get_name(), cmd_name);
+  }
+}
+
+template<typename Child>
+ModuleThread&
+DAQModule::register_thread(const std::string& name,
+                           bool (Child::*f)(),
+                           const std::string& start_cmd,
+                           const std::string& stop_cmd)
+{
+  return register_thread(name, std::bind(f, dynamic_cast<Child*>(this)), start_cmd, stop_cmd);
+}
+
 } // namespace dunedaq::appfwk
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+namespace dunedaq::appfwk {
+
+namespace detail {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32 bit integers");
+
+// now + duration, saturating at time_point::max() instead of overflowing, e.g. for microseconds::max()
+template<typename Rep, typename Period>
+std::chrono::steady_clock::time_point
+deadline_after(std::chrono::steady_clock::time_point now, std::chrono::duration<Rep, Period> duration)
+{
+  // Compared in the unit of duration, converting duration to the clock unit could overflow as well
+  auto left = std::chrono::duration_cast<std::chrono::duration<Rep, Period>>(
+    std::chrono::steady_clock::time_point::max() - now);
+  return duration >= left ? std::chrono::steady_clock::time_point::max() : now + duration;
+}
+
+// Waits while *word == expected, until the absolute CLOCK_MONOTONIC (i.e. steady_clock) deadline
+inline void
+futex_wait_until(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::steady_clock::time_point deadline)
+{
+  auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+  struct timespec ts;
+  ts.tv_sec = since_epoch.count() / 1000000000;
+  ts.tv_nsec = since_epoch.count() % 1000000000;
+  // FUTEX_WAIT_BITSET takes an absolute timeout, spurious returns (EINTR, EAGAIN) are handled by the caller
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(&word), // NOLINT
+          FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+          expected,
+          &ts,
+          nullptr,
+          FUTEX_BITSET_MATCH_ANY);
+}
+
+inline void
+futex_wake_all(std::atomic<uint32_t>& word)
+{
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX); // NOLINT
+}
+
+template<typename Condition>
+bool
+condition_holds(Condition& condition)
+{
+  if constexpr (std::is_same_v<std::remove_cv_t<Condition>, std::atomic<bool>>) {
+    return condition.load();
+  } else {
+    return static_cast<bool>(condition());
+  }
+}
+
+// Index of the first condition that holds, if any
+template<typename... Conditions>
+std::optional<size_t>
+first_condition_holding(Conditions&... conditions)
+{
+  std::optional<size_t> result;
+  size_t index = 0;
+  // Short-circuits at the first condition that holds
+  static_cast<void>(((condition_holds(conditions) ? (result = index, true) : (++index, false)) || ...));
+  return result;
+}
+
+} // namespace detail
+
+inline void
+Interruptible::interrupt_self()
+{
+  // The increment and the load of the waiter count are sequentially consistent with the waiter's registration:
+  // either the waiter is seen here and woken, or its futex call sees the new generation and does not sleep.
+  m_generation.fetch_add(1);
+  if (m_blocked_waiters.load() != 0)
+    detail::futex_wake_all(m_generation);
+}
+
+inline bool
+Interruptible::interruptible_wait(std::chrono::microseconds wait_duration,
+                                  std::atomic<bool>& wait_condition,
+                                  bool direction)
+{
+  return interruptible_wait_until(
+    detail::deadline_after(std::chrono::steady_clock::now(), wait_duration), wait_condition, direction);
+}
+
+inline bool
+Interruptible::interruptible_wait_until(std::chrono::steady_clock::time_point deadline,
+                                        std::atomic<bool>& wait_condition,
+                                        bool direction)
+{
+  // Wait condition should be false to continue wait
+  return wait_until(deadline, [&]() -> std::optional<size_t> {
+           if (wait_condition.load() != direction)
+             return 0;
+           return std::nullopt;
+         })
+    .has_value();
+}
+
+template<typename... Conditions>
+std::optional<size_t>
+Interruptible::interruptible_wait_any_for(std::chrono::microseconds wait_duration, Conditions&&... conditions)
+{
+  return interruptible_wait_any(detail::deadline_after(std::chrono::steady_clock::now(), wait_duration),
+                                std::forward<Conditions>(conditions)...);
+}
+
+template<typename... Conditions, typename>
+std::optional<size_t>
+Interruptible::interruptible_wait_any(std::chrono::steady_clock::time_point deadline, Conditions&&... conditions)
+{
+  static_assert(sizeof...(Conditions) > 0, "interruptible_wait_any needs at least one condition");
+  return wait_until(deadline, [&]() { return detail::first_condition_holding(conditions...); });
+}
+
+inline std::optional<size_t>
+Interruptible::interruptible_wait_any(std::chrono::steady_clock::time_point deadline,
+                                      const std::vector<std::function<bool()>>& conditions)
+{
+  return wait_until(deadline, [&]() -> std::optional<size_t> {
+    for (size_t i = 0; i < conditions.size(); ++i) {
+      if (conditions[i]())
+        return i;
+    }
+    return std::nullopt;
+  });
+}
+
+inline bool
+Interruptible::interruptible_wait(std::chrono::microseconds wait_duration,
+                                  std::atomic<bool>& wait_condition,
+                                  const CancellationToken& token,
+                                  bool direction)
+{
+  CancellationCallback wake_on_cancel(token, [this]() { interrupt_self(); });
+  wait_until(detail::deadline_after(std::chrono::steady_clock::now(), wait_duration), [&]() -> std::optional<size_t> {
+    if (wait_condition.load() != direction || token.stop_requested())
+      return 0;
+    return std::nullopt;
+  });
+  return wait_condition.load() != direction;
+}
+
+template<typename... Conditions>
+std::optional<size_t>
+Interruptible::cancellable_wait_any(const CancellationToken& token,
+                                    std::chrono::steady_clock::time_point deadline,
+                                    Conditions&&... conditions)
+{
+  CancellationCallback wake_on_cancel(token, [this]() { interrupt_self(); });
+  return interruptible_wait_any(
+    deadline, [&token]() { return token.stop_requested(); }, std::forward<Conditions>(conditions)...);
+}
+
+template<typename Check>
+std::optional<size_t>
+Interruptible::wait_until(std::chrono::steady_clock::time_point deadline, Check&& check)
+{
+  auto spin_end = std::min(detail::deadline_after(std::chrono::steady_clock::now(), m_spin_duration), deadline);
+
+  while (true) {
+    // Read the generation before the conditions, so that an interrupt following a change of the conditions
+    // either is seen here or prevents block() from sleeping
+    auto generation = m_generation.load();
+    auto fired = check();
+    if (fired)
+      return fired;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+      return std::nullopt;
+
+    if (now < spin_end) {
+      while (m_generation.load(std::memory_order_relaxed) == generation &&
+             std::chrono::steady_clock::now() < spin_end)
+        detail::cpu_relax();
+      continue;
+    }
+
+    block(generation, deadline);
+  }
+}
+
+inline void
+Interruptible::block(uint32_t generation, std::chrono::steady_clock::time_point deadline)
+{
+  m_blocked_waiters.fetch_add(1);
+  detail::futex_wait_until(m_generation, generation, deadline);
+  m_blocked_waiters.fetch_sub(1);
+}
+
+} // namespace dunedaq::appfwk
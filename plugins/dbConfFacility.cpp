@@ -16,17 +16,113 @@
 #include <pistache/http.h>
 #include <pistache/net.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace dunedaq::appfwk;
 using namespace Pistache;
 
+namespace {
+
+/**
+ * @brief Request header carrying the ETag of the cached copy, so that the service can answer 304
+ */
+class IfNoneMatch : public Http::Header::Header
+{
+public:
+  NAME("If-None-Match")
+
+  IfNoneMatch() = default;
+  explicit IfNoneMatch(std::string etag)
+    : m_etag(std::move(etag))
+  {
+  }
+
+  void parse(const std::string& str) override { m_etag = str; }
+  void write(std::ostream& os) const override { os << m_etag; }
+
+private:
+  std::string m_etag;
+};
+
+std::string
+fnv1a_hex(const std::string& data)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL; // NOLINT(build/unsigned)
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016lx", static_cast<unsigned long>(hash)); // NOLINT(runtime/int)
+  return std::string(buf);
+}
+
+std::string
+response_etag(const Http::Response& response)
+{
+  auto typed = response.headers().tryGet("ETag");
+  if (typed != nullptr) {
+    std::ostringstream os;
+    typed->write(os);
+    return os.str();
+  }
+  for (const auto& [name, raw] : response.headers().rawList()) {
+    if (name.size() == 4 && std::equal(name.begin(), name.end(), "etag", [](char a, char b) {
+          return std::tolower(static_cast<unsigned char>(a)) == b;
+        })) {
+      return raw.value();
+    }
+  }
+  return "";
+}
+
+int64_t
+env_or(const char* name, int64_t def)
+{
+  auto value = std::getenv(name);
+  if (value == nullptr)
+    return def;
+  return std::strtoll(value, nullptr, 10);
+}
+
+} // namespace
+
+/**
+ * The facility optionally keeps a content-addressed cache of previous responses on local disk, enabled by setting
+ * DUNEDAQ_CONF_CACHE_DIR. Response bodies are stored under objects/<hash of body>, and refs/<hash of request> records
+ * which object answers a request together with its ETag and the time it was last validated. Cached responses are
+ * revalidated with If-None-Match, and requested again unconditionally if the service answers 304 for an object
+ * missing from the cache. If the service does not answer with 200 or 304 within DUNEDAQ_CONF_DB_TIMEOUT_MS, or
+ * with a body that is not JSON, a cached copy validated less than DUNEDAQ_CONF_CACHE_MAX_STALENESS_S seconds ago is
+ * served instead.
+ */
 class dbConfFacility : public ConfFacility
 {
+  struct CacheRef
+  {
+    std::string etag;
+    std::string object;
+    int64_t validated_s = 0;
+  };
 
 public:
   explicit dbConfFacility(std::string uri)
@@ -40,51 +136,297 @@ public:
       throw dunedaq::appfwk::InvalidConfigurationURI(ERS_HERE, "Malformed URI: ", uri);
     }
     m_uri = "http" + uri.substr(sep);
+
+    auto cache_dir = std::getenv("DUNEDAQ_CONF_CACHE_DIR");
+    if (cache_dir != nullptr && std::string(cache_dir) != "") {
+      m_cache_dir = cache_dir;
+      std::error_code ec;
+      std::filesystem::create_directories(m_cache_dir / "objects", ec);
+      std::filesystem::create_directories(m_cache_dir / "refs", ec);
+      if (ec) {
+        ers::warning(ConfigurationCacheFailure(ERS_HERE, m_cache_dir.string(), ec.message()));
+        m_cache_dir.clear();
+      }
+    }
+    m_max_staleness = std::chrono::seconds(env_or("DUNEDAQ_CONF_CACHE_MAX_STALENESS_S", 300));
+    m_timeout = std::chrono::milliseconds(env_or("DUNEDAQ_CONF_DB_TIMEOUT_MS", 5000));
   }
 
+  ~dbConfFacility() { wait_prefetched(); }
+
   nlohmann::json get_data(const std::string& app_name, const std::string& cmd, const std::string& uri)
   {
-    if (!uri.empty()) {
-      auto sep = uri.find("://");
-      if (sep == std::string::npos) { // enforce URI
-        throw dunedaq::appfwk::InvalidConfigurationURI(ERS_HERE, "Malformed URI: ", uri);
+    if (auto prefetched = take_prefetched(app_name, cmd, uri)) {
+      TLOG_DEBUG(10) << app_name << " using prefetched " << cmd << " : " << *prefetched;
+      return *prefetched;
+    }
+    return fetch(app_name, cmd, uri);
+  }
+
+  std::future<nlohmann::json> get_data_async(const std::string& app_name,
+                                             const std::string& cmd,
+                                             const std::string& uri) override
+  {
+    return std::async(std::launch::async, &dbConfFacility::fetch, this, app_name, cmd, uri);
+  }
+
+  CacheCounters get_cache_counters() const override
+  {
+    CacheCounters counters;
+    counters.hits = m_hits.load();
+    counters.misses = m_misses.load();
+    counters.revalidations = m_revalidations.load();
+    counters.stale_hits = m_stale_hits.load();
+    return counters;
+  }
+
+protected:
+  typedef ConfFacility inherited;
+
+  std::string resolve_uri(const std::string& uri) override
+  {
+    if (uri.empty()) {
+      const std::lock_guard<std::mutex> lock(m_uri_mutex);
+      return m_uri;
+    }
+    auto sep = uri.find("://");
+    return sep == std::string::npos ? uri : "http" + uri.substr(sep);
+  }
+
+private:
+  nlohmann::json fetch(const std::string& app_name, const std::string& cmd, const std::string& uri)
+  {
+    std::string base_uri;
+    {
+      const std::lock_guard<std::mutex> lock(m_uri_mutex);
+      if (!uri.empty()) {
+        auto sep = uri.find("://");
+        if (sep == std::string::npos) { // enforce URI
+          throw dunedaq::appfwk::InvalidConfigurationURI(ERS_HERE, "Malformed URI: ", uri);
+        }
+        m_uri = "http" + uri.substr(sep);
       }
-      m_uri = "http" + uri.substr(sep);
+      base_uri = m_uri;
     }
 
+    auto request_uri = base_uri + "&app_name=" + app_name + "&cmd_name=" + cmd;
+    auto cached = load_ref(request_uri);
+    bool conditional = cached && !cached->etag.empty();
+    if (conditional) {
+      ++m_revalidations;
+    }
+    auto reply = send_request(request_uri, conditional ? cached->etag : "");
+
+    nlohmann::json data;
+    if (conditional && reply.code == Http::Code::Not_Modified) {
+      data = load_object(cached->object);
+      if (data.is_null()) {
+        // The service relies on a copy we no longer have, ask for the full response
+        ers::warning(ConfigurationCacheFailure(ERS_HERE, m_cache_dir.string(), "missing object " + cached->object));
+        reply = send_request(request_uri, "");
+      } else {
+        ++m_hits;
+        cached->validated_s = now_s();
+        store_ref(request_uri, *cached);
+      }
+    }
+
+    // Only a 200 answers the request, anything else falls back to the cache
+    if (data.is_null() && reply.code == Http::Code::Ok) {
+      try {
+        data = nlohmann::json::parse(reply.body);
+        ++m_misses;
+        store(request_uri, reply.etag, reply.body);
+      } catch (const nlohmann::json::exception& ex) {
+        ers::error(ConfigurationRetreival(ERS_HERE, request_uri + ": invalid response, " + ex.what()));
+      }
+    } else if (data.is_null() && reply.received) {
+      ers::error(ConfigurationRetreival(
+        ERS_HERE, request_uri + ": HTTP status " + std::to_string(static_cast<int>(reply.code))));
+    }
+
+    if (data.is_null() && cached) {
+      auto age = now_s() - cached->validated_s;
+      if (age <= m_max_staleness.count()) {
+        data = load_object(cached->object);
+        if (!data.is_null()) {
+          ++m_stale_hits;
+          ers::warning(StaleConfigurationServed(ERS_HERE, request_uri, age));
+        }
+      }
+    }
+
+    TLOG_DEBUG(10) << app_name << " received " << cmd << " : " << data;
+    TLOG_DEBUG(11) << "Cache hits " << m_hits << ", misses " << m_misses << ", revalidations " << m_revalidations
+                   << ", stale hits " << m_stale_hits;
+    return data;
+  }
+
+  /**
+   * @brief Status, body and ETag of a response, copied out of the client callback
+   */
+  struct Reply
+  {
+    bool received = false;
+    Http::Code code = Http::Code::Ok;
+    std::string body;
+    std::string etag;
+  };
+
+  // Send a GET request, conditional if etag is not empty, and wait for the response for at most the timeout. The
+  // response is only copied in the callback: it is interpreted by the caller, where errors can be reported.
+  Reply send_request(const std::string& request_uri, const std::string& etag)
+  {
     Http::Client client;
     auto opts = Http::Client::options().threads(1).keepAlive(true).maxConnectionsPerHost(8);
     client.init(opts);
 
-    TLOG_DEBUG() << "HTTP client instanciated and options set " << m_uri;
-    auto resp = client.get(m_uri + "&app_name=" + app_name + "&cmd_name=" + cmd).send();
-    nlohmann::json data;
+    TLOG_DEBUG() << "HTTP client instanciated and options set " << request_uri;
+    auto request = client.get(request_uri);
+    if (!etag.empty()) {
+      request.header<IfNoneMatch>(etag);
+    }
+    auto resp = request.send();
+    Reply reply;
+    std::mutex reply_mutex; // the callback runs on the client thread, until the client is shut down
     std::vector<Async::Promise<Http::Response>> responses;
 
-    resp.then([&](Http::Response response) { data = nlohmann::json::parse(response.body()); },
-              [&](std::exception_ptr e) {
-                try {
-                  std::rethrow_exception(e);
-                } catch (const Pistache::Error& e) {
-                  ers::error(dunedaq::appfwk::ConfigurationRetreival(ERS_HERE, m_uri, e.what()));
-                }
-              });
+    resp.then(
+      [&](Http::Response response) {
+        const std::lock_guard<std::mutex> lock(reply_mutex);
+        reply.code = response.code();
+        reply.body = response.body();
+        reply.etag = response_etag(response);
+        reply.received = true;
+      },
+      [&](std::exception_ptr e) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const std::exception& e) {
+          ers::error(ConfigurationRetreival(ERS_HERE, request_uri + ": " + e.what()));
+        }
+      });
 
     responses.push_back(std::move(resp));
     auto sync = Async::whenAll(responses.begin(), responses.end());
     Async::Barrier<std::vector<Http::Response>> barrier(sync);
-    barrier.wait_for(std::chrono::seconds(5));
+    barrier.wait_for(m_timeout);
     client.shutdown();
 
-    TLOG_DEBUG(10) << app_name << " received " << cmd << " : " << data;
-    return data;
+    const std::lock_guard<std::mutex> lock(reply_mutex);
+    return reply;
   }
 
-protected:
-  typedef ConfFacility inherited;
+  static int64_t now_s()
+  {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+  }
 
-private:
+  std::optional<CacheRef> load_ref(const std::string& request_uri)
+  {
+    if (m_cache_dir.empty())
+      return std::nullopt;
+
+    std::ifstream ifs(m_cache_dir / "refs" / (fnv1a_hex(request_uri) + ".json"));
+    if (!ifs.is_open())
+      return std::nullopt;
+    try {
+      auto ref_json = nlohmann::json::parse(ifs);
+      if (ref_json.at("uri").get<std::string>() != request_uri)
+        return std::nullopt;
+      CacheRef ref;
+      ref.etag = ref_json.at("etag").get<std::string>();
+      ref.object = ref_json.at("object").get<std::string>();
+      ref.validated_s = ref_json.at("validated_s").get<int64_t>();
+      return ref;
+    } catch (const std::exception& ex) {
+      TLOG_DEBUG(11) << "Ignoring unreadable cache entry for " << request_uri << ": " << ex.what();
+      return std::nullopt;
+    }
+  }
+
+  nlohmann::json load_object(const std::string& object)
+  {
+    std::ifstream ifs(m_cache_dir / "objects" / (object + ".json"));
+    if (!ifs.is_open())
+      return nlohmann::json();
+    try {
+      return nlohmann::json::parse(ifs);
+    } catch (const std::exception& ex) {
+      TLOG_DEBUG(11) << "Ignoring unreadable cache object " << object << ": " << ex.what();
+      return nlohmann::json();
+    }
+  }
+
+  void store(const std::string& request_uri, const std::string& etag, const std::string& body)
+  {
+    if (m_cache_dir.empty())
+      return;
+
+    CacheRef ref;
+    ref.etag = etag;
+    ref.object = fnv1a_hex(body);
+    ref.validated_s = now_s();
+
+    auto object_path = m_cache_dir / "objects" / (ref.object + ".json");
+    if (!std::filesystem::exists(object_path)) {
+      write_atomically(object_path, body);
+    }
+    store_ref(request_uri, ref);
+  }
+
+  void store_ref(const std::string& request_uri, const CacheRef& ref)
+  {
+    nlohmann::json ref_json;
+    ref_json["uri"] = request_uri;
+    ref_json["etag"] = ref.etag;
+    ref_json["object"] = ref.object;
+    ref_json["validated_s"] = ref.validated_s;
+    write_atomically(m_cache_dir / "refs" / (fnv1a_hex(request_uri) + ".json"), ref_json.dump());
+  }
+
+  // Applications sharing a cache directory may restart together, so never expose a partially written file
+  void write_atomically(const std::filesystem::path& path, const std::string& content)
+  {
+    // A unique name per writer: threads of one application, as well as applications, may store the same file
+    std::string tmp_name = path.string() + ".XXXXXX";
+    int fd = ::mkstemp(tmp_name.data());
+    if (fd < 0) {
+      ers::warning(ConfigurationCacheFailure(ERS_HERE, m_cache_dir.string(), "cannot create " + tmp_name));
+      return;
+    }
+    // mkstemp creates the file readable by its owner only, the cache is readable like any file written by ofstream
+    ::fchmod(fd, 0644);
+    ::close(fd);
+    std::filesystem::path tmp_path(tmp_name);
+    {
+      std::ofstream ofs(tmp_path, std::ios::trunc);
+      ofs << content;
+      if (!ofs.good()) {
+        ers::warning(ConfigurationCacheFailure(ERS_HERE, m_cache_dir.string(), "cannot write " + tmp_name));
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+        return;
+      }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+      ers::warning(ConfigurationCacheFailure(ERS_HERE, m_cache_dir.string(), ec.message()));
+      std::filesystem::remove(tmp_path, ec);
+    }
+  }
+
+  std::mutex m_uri_mutex;
   std::string m_uri;
+  std::filesystem::path m_cache_dir;
+  std::chrono::seconds m_max_staleness;
+  std::chrono::milliseconds m_timeout;
+  std::atomic<uint64_t> m_hits{ 0 };
+  std::atomic<uint64_t> m_misses{ 0 };
+  std::atomic<uint64_t> m_revalidations{ 0 };
+  std::atomic<uint64_t> m_stale_hits{ 0 };
 };
 
 extern "C"
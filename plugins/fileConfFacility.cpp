@@ -12,6 +12,9 @@
 #include "logging/Logging.hpp"
 
 #include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
 
 using namespace dunedaq::appfwk;
 
@@ -25,17 +28,52 @@ public:
     m_uri = uri;
   }
 
+  ~fileConfFacility() { wait_prefetched(); }
+
   nlohmann::json get_data(const std::string& app_name, const std::string& cmd, const std::string& uri)
+  {
+    if (auto prefetched = take_prefetched(app_name, cmd, uri)) {
+      TLOG_DEBUG(10) << app_name << " using prefetched " << cmd << " : " << *prefetched;
+      return *prefetched;
+    }
+    return load(app_name, cmd, uri);
+  }
+
+  std::future<nlohmann::json> get_data_async(const std::string& app_name,
+                                             const std::string& cmd,
+                                             const std::string& uri) override
+  {
+    return std::async(std::launch::async, &fileConfFacility::load, this, app_name, cmd, uri);
+  }
+
+protected:
+  typedef ConfFacility inherited;
+
+  std::string resolve_uri(const std::string& uri) override
   {
     if (!uri.empty())
-      m_uri = uri;
+      return uri;
+    const std::lock_guard<std::mutex> lock(m_uri_mutex);
+    return m_uri;
+  }
+
+private:
+  nlohmann::json load(const std::string& app_name, const std::string& cmd, const std::string& uri)
+  {
+    std::string base_uri;
+    {
+      const std::lock_guard<std::mutex> lock(m_uri_mutex);
+      if (!uri.empty())
+        m_uri = uri;
+      base_uri = m_uri;
+    }
 
-    auto sep = m_uri.find("://");
+    auto sep = base_uri.find("://");
     std::string dirname;
     if (sep == std::string::npos) { // bad URI!
       throw InvalidConfigurationURI(ERS_HERE, uri);
     } else {
-      dirname = m_uri.substr(sep + 3);
+      dirname = base_uri.substr(sep + 3);
     }
 
     std::string fname = dirname + "/" + app_name + "_" + cmd + ".json";
@@ -57,10 +95,7 @@ public:
     return data;
   }
 
-protected:
-  typedef ConfFacility inherited;
-
-private:
+  std::mutex m_uri_mutex;
   std::string m_uri;
 };
 
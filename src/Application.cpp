@@ -10,34 +10,79 @@
 #include "Application.hpp"
 
 #include "appfwk/Issues.hpp"
+#include "appfwk/TimerService.hpp"
+#include "appfwk/TscClock.hpp"
 #include "appfwk/opmon/application.pb.h"
 #include "appfwk/cmd/Nljs.hpp"
 #include "rcif/cmd/Nljs.hpp"
 
 #include "logging/Logging.hpp"
 
+#include <algorithm>
 #include <string>
-#include <unistd.h>
+#include <vector>
 
 #include "confmodel/Session.hpp"
 #include "confmodel/Application.hpp"
+#include "confmodel/FSMconfiguration.hpp"
+#include "confmodel/FSMtransition.hpp"
 #include "confmodel/OpMonURI.hpp"
+#include "confmodel/RCApplication.hpp"
+#include "confmodel/Segment.hpp"
 
 namespace dunedaq {
 namespace appfwk {
 
+namespace {
+
+// The FSM of an application is the one of the controller of the segment the application belongs to
+const confmodel::FSMconfiguration*
+find_fsm(const confmodel::Segment* segment, const std::string& app_name)
+{
+  if (segment == nullptr)
+    return nullptr;
+
+  for (auto app : segment->get_applications()) {
+    if (app->UID() == app_name) {
+      auto controller = segment->get_controller();
+      return controller == nullptr ? nullptr : controller->get_fsm();
+    }
+  }
+  for (auto child : segment->get_segments()) {
+    if (auto fsm = find_fsm(child, app_name))
+      return fsm;
+  }
+  return nullptr;
+}
+
+} // namespace
+
 Application::Application(std::string appname,
                          std::string session,
                          std::string cmdlibimpl,
                          std::string confimpl)
   : OpMonManager(session, appname, std::make_unique<ConfigurationManager>(confimpl, appname, session)->session()->get_opmon_uri()->get_URI(appname))
   , NamedObject(appname)
-  , m_state("NONE")
+  , m_n_states(0)
+  , m_state(0)
+  , m_other_transition(nullptr)
+  , m_fsm_states_end(0)
   , m_busy(false)
   , m_error(false)
+  , m_queue_capacity(0)
+  , m_queued_commands(0)
+  , m_next_ticket(0)
+  , m_serving_ticket(0)
+  , m_max_queue_wait_us(0)
   , m_initialized(false)
   , m_config_mgr(std::make_shared<ConfigurationManager>(confimpl, appname, session))
+  , m_session_name(session)
+  , m_confimpl(confimpl)
 {
+  compile_fsm();
+  set_state("NONE");
+  register_introspection_commands();
+
   m_runinfo.set_running(false);
   m_runinfo.set_run_number(0);
   m_runinfo.set_run_time(0);
@@ -56,10 +101,14 @@ Application::Application(std::string appname,
 void
 Application::init()
 {
+  // Command traces and latencies convert TscClock timestamps: measure its rate now, not in the first command
+  TscClock::calibrate();
   m_cmd_fac->set_commanded(*this, get_name());
+  register_node("timers", get_timer_service());
   m_mod_mgr.initialize(m_config_mgr, *this);
   set_state("INITIAL");
   m_initialized = true;
+  prefetch_next_commands();
 }
 
 void
@@ -73,18 +122,138 @@ Application::run(std::atomic<bool>& end_marker)
   m_cmd_fac->run(end_marker);
 
   m_mod_mgr.cleanup();
+  dump_history();
 }
 
 void
 Application::execute(const dataobj_t& cmd_data)
+{
+  std::chrono::steady_clock::time_point admitted;
+  if (!m_recording.is_open()) {
+    execute_command(cmd_data, admitted);
+    return;
+  }
+
+  // The arrival is accounted for when the command is received, the line is written once its outcome is known
+  auto received = std::chrono::steady_clock::now();
+  dataobj_t line;
+  {
+    const std::lock_guard<std::mutex> lock(m_recording_mutex);
+    if (m_first_arrival.time_since_epoch().count() == 0)
+      m_first_arrival = m_last_arrival = received;
+    line["received_ms"] = std::chrono::duration<double, std::milli>(received - m_first_arrival).count();
+    line["interarrival_ms"] = std::chrono::duration<double, std::milli>(received - m_last_arrival).count();
+    m_last_arrival = received;
+  }
+  line["command"] = cmd_data;
+
+  // Time in the admission queue and execution time are separate, so that replays at another speed compare
+  auto write_line = [&](bool success) {
+    auto ended = std::chrono::steady_clock::now();
+    if (admitted.time_since_epoch().count() == 0) // introspection command
+      admitted = received;
+    line["queued_ms"] = std::chrono::duration<double, std::milli>(admitted - received).count();
+    line["duration_ms"] = std::chrono::duration<double, std::milli>(ended - admitted).count();
+    line["success"] = success;
+    const std::lock_guard<std::mutex> lock(m_recording_mutex);
+    m_recording << line.dump() << std::endl;
+  };
+
+  try {
+    execute_command(cmd_data, admitted);
+  } catch (...) {
+    write_line(false);
+    throw;
+  }
+  write_line(true);
+}
+
+void
+Application::set_command_recording(const std::string& path)
+{
+  const std::lock_guard<std::mutex> lock(m_recording_mutex);
+  if (m_recording.is_open())
+    m_recording.close();
+  if (path.empty())
+    return;
+
+  m_recording.open(path, std::ios::out | std::ios::app);
+  if (!m_recording.is_open()) {
+    throw BadFile(ERS_HERE, path);
+  }
+  TLOG() << "Recording commands to " << path;
+}
+
+void
+Application::set_command_data_service(const std::string& uri)
+{
+  if (uri.empty()) {
+    m_cmd_data_fac.reset();
+    return;
+  }
+  m_cmd_data_fac = make_conf_facility(uri);
+  register_node("command_data", m_cmd_data_fac);
+  TLOG() << "Taking command data from " << uri;
+}
+
+void
+Application::execute_command(const dataobj_t& cmd_data, std::chrono::steady_clock::time_point& admitted)
 {
   auto rc_cmd = cmd_data.get<rcif::cmd::RCCommand>();
   std::string cmdname = rc_cmd.id;
-  if (!is_cmd_valid(cmd_data)) {
-    throw InvalidCommand(ERS_HERE, cmdname, get_state(), m_error.load(), m_busy.load());
+
+  // Introspection commands bypass the busy gate and the admission queue
+  if (is_introspection_command(cmdname)) {
+    auto reply = introspect(cmdname).dump();
+    TLOG() << "Introspection command " << cmdname << ": " << reply;
+    opmon::IntrospectionReply ir;
+    ir.set_command(cmdname);
+    ir.set_reply(reply);
+    ir.set_sequence(m_introspection_replies.fetch_add(1));
+    publish(std::move(ir), {}, opmonlib::to_level(opmonlib::EntryOpMonLevel::kTopPriority));
+    return;
   }
 
-  m_busy.store(true);
+  CommandRecord record;
+  record.id = cmdname;
+  record.entry_state = rc_cmd.entry_state;
+  record.received = std::chrono::system_clock::now();
+
+  try {
+    admit_command(cmd_data, cmdname);
+  } catch (InvalidCommand& ex) {
+    // Rejected on arrival, or when leaving the queue after waiting in it
+    record.started = std::chrono::system_clock::now();
+    admitted = std::chrono::steady_clock::now();
+    record_command(std::move(record), ex.message());
+    throw;
+  }
+
+  record.started = std::chrono::system_clock::now();
+  auto cmd_start_time = std::chrono::steady_clock::now();
+  admitted = cmd_start_time;
+
+  // Usually prefetched while the application was idle
+  if (m_cmd_data_fac != nullptr && (rc_cmd.data.is_null() || rc_cmd.data.empty())) {
+    try {
+      rc_cmd.data = m_cmd_data_fac->get_data(get_name(), cmdname, "");
+    } catch (ers::Issue& ex) {
+      release_command();
+      record_command(std::move(record), ex.message());
+      throw;
+    }
+  }
+
+  auto previous_progress = m_mod_mgr.get_progress();
+  auto command_progress = [&]() {
+    auto progress = m_mod_mgr.get_progress();
+    return progress == previous_progress ? nullptr : progress;
+  };
+  auto transition = m_transitions.find(cmdname);
+  auto fsm_transition = transition != m_transitions.end() && transition->second.get() != m_other_transition &&
+                            m_state.load(std::memory_order_acquire) < m_fsm_states_end
+                          ? transition->second.get()
+                          : nullptr;
 
   if (cmdname == "start") {
     auto cmd_obj = rc_cmd.data.get<cmd::CmdObj>();
@@ -108,15 +277,59 @@ Application::execute(const dataobj_t& cmd_data)
   }
 
   try {
-    m_mod_mgr.execute(cmdname, rc_cmd.data);
-    m_busy.store(false);
+    if (cmdname == "reconf" && m_incremental_reconf) {
+      // Re-read the configuration and apply it only to the modules whose configuration changed
+      auto app_name = get_name();
+      auto config_mgr = std::make_shared<ConfigurationManager>(m_confimpl, app_name, m_session_name);
+      m_mod_mgr.reconfigure(config_mgr, rc_cmd.data);
+      m_config_mgr = config_mgr;
+      if (m_cmd_data_fac != nullptr)
+        m_cmd_data_fac->invalidate_prefetched();
+    } else {
+      m_mod_mgr.execute(cmdname, rc_cmd.data);
+    }
     if (rc_cmd.exit_state != "ANY")
       set_state(rc_cmd.exit_state);
+    else if (fsm_transition != nullptr)
+      m_state.store(fsm_transition->dest, std::memory_order_release);
+    release_command();
   } catch (ers::Issue& ex) {
-    m_busy.store(false);
     m_error.store(true);
+    release_command();
+    record_command(std::move(record), ex.message(), command_progress());
+    dump_history();
     throw;
   }
+  record_command(std::move(record), "", command_progress());
+
+  (transition == m_transitions.end() ? m_other_transition : transition->second.get())
+    ->record(std::chrono::steady_clock::now() - cmd_start_time);
+
+  prefetch_next_commands();
+}
+
+void
+Application::prefetch_next_commands()
+{
+  if (m_cmd_data_fac == nullptr || m_busy.load() || m_error.load())
+    return;
+  if (m_queued_commands.load() > 0)
+    return;
+
+  // Outside of the FSM, any command may come next: nothing is prefetched
+  auto state = m_state.load(std::memory_order_acquire);
+  if (state >= m_fsm_states_end)
+    return;
+  std::vector<std::string> next_commands;
+  for (const auto& [name, transition] : m_transitions) {
+    if (transition.get() != m_other_transition && transition->source == state)
+      next_commands.push_back(name);
+  }
+  if (next_commands.empty())
+    return;
+
+  TLOG_DEBUG(1) << "Prefetching the data of " << next_commands.size() << " command(s) in state " << get_state();
+  m_cmd_data_fac->prefetch(get_name(), next_commands);
 }
 
 void
@@ -126,13 +339,23 @@ Application::generate_opmon_data()
   ai.set_state(get_state());
   ai.set_busy(m_busy.load());
   ai.set_error(m_error.load());
+  ai.set_queued_commands(m_queued_commands.load());
+  ai.set_max_queue_wait_ms(m_max_queue_wait_us.exchange(0) / 1000.);
 
-  char hostname[256];
-  auto res = gethostname(hostname, 256);
-  if (res < 0)
-    ai.set_host("Unknown");
-  else
-    ai.set_host (std::string(hostname));
+  ai.set_host(m_resources.hostname());
+  auto usage = m_resources.sample();
+  ai.set_rss_bytes(usage.rss_bytes);
+  ai.set_vsize_bytes(usage.vsize_bytes);
+  ai.set_rss_growth_bytes(usage.rss_growth_bytes);
+  ai.set_user_time_s(usage.user_time_s);
+  ai.set_system_time_s(usage.system_time_s);
+  ai.set_cpu_utilisation(usage.cpu_utilisation);
+  ai.set_voluntary_ctx_switches(usage.voluntary_ctx_switches);
+  ai.set_involuntary_ctx_switches(usage.involuntary_ctx_switches);
+  ai.set_minor_faults(usage.minor_faults);
+  ai.set_major_faults(usage.major_faults);
+  ai.set_threads(usage.threads);
+  ai.set_open_fds(usage.open_fds);
 
   publish(std::move(ai), {}, opmonlib::to_level(opmonlib::EntryOpMonLevel::kTopPriority));
 
@@ -142,6 +365,22 @@ Application::generate_opmon_data()
   }
 
   publish( decltype(m_runinfo)(m_runinfo) );
+
+  for (const auto& [name, transition] : m_transitions) {
+    auto latency = transition->latency.summary();
+    if (latency.count == 0)
+      continue;
+    opmon::TransitionInfo ti;
+    ti.set_count(latency.count);
+    ti.set_last_ms(transition->last_ns.load(std::memory_order_relaxed) / 1e6);
+    ti.set_mean_ms(latency.mean / 1e6);
+    ti.set_max_ms(latency.max / 1e6);
+    ti.set_p50_ms(latency.p50 / 1e6);
+    ti.set_p90_ms(latency.p90 / 1e6);
+    ti.set_p99_ms(latency.p99 / 1e6);
+    ti.set_p999_ms(latency.p999 / 1e6);
+    publish(std::move(ti), { { "transition", name } });
+  }
 }
 
 bool
@@ -150,12 +389,190 @@ Application::is_cmd_valid(const dataobj_t& cmd_data)
   if (m_busy.load() || m_error.load())
     return false;
 
-  std::string state = get_state();
-  std::string entry_state = cmd_data.get<rcif::cmd::RCCommand>().entry_state;
-  if (entry_state == "ANY" || state == entry_state)
-    return true;
+  auto rc_cmd = cmd_data.get<rcif::cmd::RCCommand>();
+  auto state = m_state.load(std::memory_order_acquire);
+  if (rc_cmd.entry_state != "ANY")
+    return find_state(rc_cmd.entry_state) == state;
+
+  // Without an explicit entry state, FSM transitions are only legal from their source state. States that are not
+  // part of the FSM (e.g. NONE and INITIAL set by the application itself) do not restrict anything. Transitions are
+  // named after their command, see compile_fsm.
+  auto transition = m_transitions.find(rc_cmd.id);
+  if (transition != m_transitions.end() && transition->second.get() != m_other_transition && state < m_fsm_states_end)
+    return transition->second->source == state;
+
+  return true;
+}
+
+void
+Application::register_introspection_commands()
+{
+  m_introspection_commands["get_status"] = [this]() {
+    dataobj_t status;
+    status["state"] = get_state();
+    status["busy"] = m_busy.load();
+    status["error"] = m_error.load();
+    status["queued_commands"] = m_queued_commands.load();
+    return status;
+  };
+
+  m_introspection_commands["get_history"] = [this]() { return m_history.to_json(); };
+
+  m_introspection_commands["get_progress"] = [this]() {
+    auto progress = m_mod_mgr.get_progress();
+    return progress == nullptr ? dataobj_t::object() : progress->to_json();
+  };
+
+  // Not read-only, but bypasses the busy gate like the introspection commands, otherwise it would wait for the
+  // very command it aborts
+  m_introspection_commands["abort"] = [this]() {
+    dataobj_t result;
+    auto progress = m_mod_mgr.get_progress();
+    result["command"] = progress == nullptr ? "" : progress->command;
+    result["aborted"] = m_mod_mgr.abort("abort command");
+    return result;
+  };
+}
+
+void
+Application::record_command(CommandRecord&& record,
+                            const std::string& error,
+                            std::shared_ptr<const DAQModuleManager::CommandProgress> progress)
+{
+  record.ended = std::chrono::system_clock::now();
+  record.exit_state = get_state();
+  record.success = error.empty();
+  record.error = error;
+
+  // Per-module details are taken from the progress snapshot of the command, if it got as far as the modules
+  if (progress != nullptr) {
+    for (const auto& [name, module] : progress->modules) {
+      auto start = module.start_ns.load();
+      auto end = module.end_ns.load();
+      if (start != 0 && end != 0)
+        record.module_durations_ms[name] = (end - start) / 1e6;
+      if (module.failed.load())
+        record.failed_modules.push_back(name);
+    }
+  }
+
+  m_history.record(std::move(record));
+}
+
+void
+Application::dump_history() const
+{
+  if (m_history_dump_path.empty())
+    return;
+  if (m_history.dump(m_history_dump_path)) {
+    TLOG() << "Command history written to " << m_history_dump_path;
+  } else {
+    ers::warning(BadFile(ERS_HERE, m_history_dump_path));
+  }
+}
+
+void
+Application::admit_command(const dataobj_t& cmd_data, const std::string& cmdname)
+{
+  std::unique_lock<std::mutex> lock(m_queue_mutex);
+
+  // Commands arriving while others are queued go behind them, even if the application just became idle
+  if (m_busy.load() || m_queued_commands.load() > 0) {
+    if (m_error.load() || m_queued_commands.load() >= m_queue_capacity) {
+      throw InvalidCommand(ERS_HERE, cmdname, get_state(), m_error.load(), m_busy.load());
+    }
+
+    auto ticket = m_next_ticket++;
+    ++m_queued_commands;
+    TLOG_DEBUG(1) << "Queueing command " << cmdname << ", " << m_queued_commands.load() << " command(s) waiting";
+    auto enqueue_time = std::chrono::steady_clock::now();
+    m_queue_cv.wait(lock, [&] { return !m_busy.load() && m_serving_ticket == ticket; });
+    ++m_serving_ticket;
+    --m_queued_commands;
+
+    uint64_t wait_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - enqueue_time).count();
+    auto max = m_max_queue_wait_us.load();
+    while (wait_us > max && !m_max_queue_wait_us.compare_exchange_weak(max, wait_us)) {
+    }
+    TLOG_DEBUG(1) << "Dequeued command " << cmdname << " after " << wait_us << " us";
+  }
+
+  // The state precondition of a queued command is checked against the state left by the commands before it
+  if (!is_cmd_valid(cmd_data)) {
+    m_queue_cv.notify_all();
+    throw InvalidCommand(ERS_HERE, cmdname, get_state(), m_error.load(), m_busy.load());
+  }
+
+  m_busy.store(true);
+}
+
+void
+Application::release_command()
+{
+  {
+    const std::lock_guard<std::mutex> lock(m_queue_mutex);
+    m_busy.store(false);
+  }
+  m_queue_cv.notify_all();
+}
+
+void
+Application::compile_fsm()
+{
+  auto fsm = find_fsm(m_config_mgr->session()->get_segment(), get_name());
+  if (fsm == nullptr) {
+    TLOG_DEBUG(1) << "No FSM configuration found for " << get_name() << ", transitions are not checked";
+  } else {
+    for (const auto& state : fsm->get_states())
+      intern_state(state);
+    intern_state(fsm->get_initial_state());
+    // FSMtransition does not refer to its command: like run control, we take the transition named after a command
+    for (auto transition : fsm->get_transitions()) {
+      auto entry = std::make_unique<Transition>();
+      entry->source = intern_state(transition->get_source());
+      entry->dest = intern_state(transition->get_dest());
+      m_transitions[transition->UID()] = std::move(entry);
+    }
+  }
+  m_fsm_states_end = m_n_states.load();
+
+  auto other = std::make_unique<Transition>();
+  other->source = other->dest = s_max_states;
+  m_other_transition = other.get();
+  m_transitions.emplace("other", std::move(other));
+}
+
+Application::state_id_t
+Application::find_state(const std::string& name) const
+{
+  auto n_states = m_n_states.load(std::memory_order_acquire);
+  for (size_t i = 0; i < n_states; ++i) {
+    if (m_state_names[i] == name)
+      return i;
+  }
+  return s_max_states;
+}
+
+Application::state_id_t
+Application::intern_state(const std::string& name)
+{
+  auto id = find_state(name);
+  if (id != s_max_states)
+    return id;
+
+  const std::lock_guard<std::mutex> lock(m_state_table_mutex);
+  auto n_states = m_n_states.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < n_states; ++i) {
+    if (m_state_names[i] == name)
+      return i;
+  }
+  if (n_states == s_max_states)
+    throw TooManyStates(ERS_HERE, name, s_max_states);
 
-  return false;
+  m_state_names[n_states] = name;
+  m_n_states.store(n_states + 1, std::memory_order_release);
+  return n_states;
 }
 
 } // namespace appfwk
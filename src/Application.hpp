@@ -16,16 +16,25 @@
 #include "cmdlib/CommandFacility.hpp"
 #include "cmdlib/CommandedObject.hpp"
 
+#include "CommandHistory.hpp"
 #include "DAQModuleManager.hpp"
+#include "ResourceMonitor.hpp"
 #include "appfwk/ConfFacility.hpp"
+#include "appfwk/LatencyHistogram.hpp"
 
 #include "opmonlib/OpMonManager.hpp"
 
 #include "ers/Issue.hpp"
 #include "nlohmann/json.hpp"
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -52,6 +61,13 @@ ERS_DECLARE_ISSUE(appfwk,         ///< Namespace
                   ((bool)busy)                      ///< Message parameters // NOLINT
 )
 
+ERS_DECLARE_ISSUE(appfwk,                                                           ///< Namespace
+                  TooManyStates,                                                    ///< Issue class name
+                  "Cannot add state " << state << ", the state table is full (" << max << " states)", ///< Message
+                  ((std::string)state)                                              ///< Message parameters
+                  ((size_t)max)                                                     ///< Message parameters
+)
+
 // Re-enable coverage collection LCOV_EXCL_STOP
 namespace appfwk {
 
@@ -80,32 +96,150 @@ public:
   // Check whether the command can be accepted
   bool is_cmd_valid(const dataobj_t& cmd_data);
 
-  // hook for metric generation
-  void generate_opmon_data() override;
-  
-  // State synch getter & setter
-  void set_state(std::string s)
+  // File the command history is written to when a command fails and when the application exits, none if empty
+  void set_history_dump_path(const std::string& path) { m_history_dump_path = path; }
+
+  // Append every incoming command, with its arrival time and outcome, to a JSON lines file for later replay
+  void set_command_recording(const std::string& path);
+
+  // Read-only introspection commands are registered separately from the FSM commands. They are answered from
+  // snapshots of the application, without waiting for nor blocking the command being executed, and the answer of
+  // those received as commands is published as an IntrospectionReply opmon entry. The "abort" command, which
+  // cancels the command being executed, is handled the same way.
+  bool is_introspection_command(const std::string& id) const { return m_introspection_commands.count(id) != 0; }
+  dataobj_t introspect(const std::string& id) const { return m_introspection_commands.at(id)(); }
+
+  // Cancel the token of commands running for longer than timeout (zero for none) or, with fail_fast, as soon as
+  // one module fails, see DAQModuleManager::set_command_timeout and DAQModuleManager::set_fail_fast
+  void set_command_cancellation(std::chrono::milliseconds timeout, bool fail_fast)
   {
-    const std::lock_guard<std::mutex> lock(m_mutex);
-    m_state = s;
+    m_mod_mgr.set_command_timeout(timeout);
+    m_mod_mgr.set_fail_fast(fail_fast);
   }
-  std::string get_state()
+
+  // Keep modules and connections resident across scrap, see DAQModuleManager::set_warm_restart
+  void set_warm_restart(bool warm_restart) { m_mod_mgr.set_warm_restart(warm_restart); }
+
+  // On reconf, re-read the configuration and reconfigure only the modules whose configuration changed, see
+  // DAQModuleManager::reconfigure. Otherwise (the default) reconf is dispatched to the modules like other commands.
+  void set_incremental_reconf(bool incremental) { m_incremental_reconf = incremental; }
+
+  // Take the data of commands sent without any from the ConfFacility at uri (none if empty). While idle, the data of
+  // the FSM transitions leaving the current state is prefetched from it.
+  void set_command_data_service(const std::string& uri);
+
+  // Write the timeline of command execution to a Chrome trace-event JSON file, throws BadFile if it cannot be opened
+  void set_trace_file(const std::string& path) { m_mod_mgr.set_trace_file(path, get_name()); }
+
+  // Number of commands accepted while a command is executing, 0 to reject them. Queued commands are executed in
+  // order of arrival, and their validity is checked when they are dequeued.
+  void set_command_queue_depth(size_t depth)
   {
-    const std::lock_guard<std::mutex> lock(m_mutex);
-    return m_state;
+    const std::lock_guard<std::mutex> lock(m_queue_mutex);
+    m_queue_capacity = depth;
   }
 
+  // hook for metric generation
+  void generate_opmon_data() override;
+  
+  // State synch getter & setter
+  void set_state(const std::string& s) { m_state.store(intern_state(s), std::memory_order_release); }
+  std::string get_state() const { return m_state_names[m_state.load(std::memory_order_acquire)]; }
+
 private:
-  std::mutex m_mutex;
-  std::string m_state;
+  using state_id_t = uint32_t;
+  static constexpr size_t s_max_states = 64;
+
+  // One entry of the compiled transition table, with the latency statistics of the transition
+  struct Transition
+  {
+    state_id_t source;
+    state_id_t dest;
+    LatencyHistogram latency; // in ns
+    std::atomic<uint64_t> last_ns{ 0 };
+
+    void record(std::chrono::nanoseconds duration)
+    {
+      last_ns.store(duration.count(), std::memory_order_relaxed);
+      latency.record(duration);
+    }
+  };
+
+  // Wait for our turn if a command is executing, then mark the application busy with this command
+  void admit_command(const dataobj_t& cmd_data, const std::string& cmdname);
+  // Clear the busy flag and let the next queued command in
+  void release_command();
+
+  // Sets admitted to the time the command left the admission queue, or was rejected
+  void execute_command(const dataobj_t& cmd_data, std::chrono::steady_clock::time_point& admitted);
+
+  void register_introspection_commands();
+  void record_command(CommandRecord&& record,
+                      const std::string& error = "",
+                      std::shared_ptr<const DAQModuleManager::CommandProgress> progress = nullptr);
+  void dump_history() const;
+
+  // Start retrieving the data of the commands the application may receive next, if it is idle
+  void prefetch_next_commands();
+
+  // Build the state table and the transition table from the FSM of the controller of our segment
+  void compile_fsm();
+
+  // Look up a state name without locking, returns s_max_states when the name is unknown
+  state_id_t find_state(const std::string& name) const;
+  // Look up a state name, adding it to the table when it is not there yet
+  state_id_t intern_state(const std::string& name);
+
+  // The state names only ever grow: a slot is written before m_n_states is increased, so readers never look at a
+  // slot that is being written. Only adding a name takes m_state_table_mutex.
+  std::array<std::string, s_max_states> m_state_names;
+  std::atomic<size_t> m_n_states;
+  std::mutex m_state_table_mutex;
+  std::atomic<state_id_t> m_state;
+
+  // Compiled once in the constructor and never modified afterwards, so it is read without locking. Commands that are
+  // not FSM transitions are accounted under "other".
+  std::map<std::string, std::unique_ptr<Transition>> m_transitions;
+  Transition* m_other_transition;
+  state_id_t m_fsm_states_end; // ids below this value are states of the FSM
+
   std::atomic<bool> m_busy;
   std::atomic<bool> m_error;
+
+  // Command admission queue: queued commands take a ticket and are executed in ticket order. m_busy and
+  // m_queued_commands are only modified with m_queue_mutex held, but can be read without it.
+  std::mutex m_queue_mutex;
+  std::condition_variable m_queue_cv;
+  size_t m_queue_capacity;
+  std::atomic<size_t> m_queued_commands;
+  uint64_t m_next_ticket;
+  uint64_t m_serving_ticket;
+  std::atomic<uint64_t> m_max_queue_wait_us;
+
+  ResourceMonitor m_resources;
+
+  // Filled in the constructor and never modified afterwards
+  std::map<std::string, std::function<dataobj_t()>> m_introspection_commands;
+  std::atomic<uint64_t> m_introspection_replies{ 0 };
+
+  CommandHistory m_history;
+  std::string m_history_dump_path;
+
+  // Command recording, one JSON object per line. Opened before the application runs.
+  std::mutex m_recording_mutex;
+  std::ofstream m_recording;
+  std::chrono::steady_clock::time_point m_first_arrival;
+  std::chrono::steady_clock::time_point m_last_arrival;
   bool m_initialized;
   std::chrono::time_point<std::chrono::steady_clock> m_run_start_time;
   dunedaq::rcif::opmon::RunInfo m_runinfo;
   DAQModuleManager m_mod_mgr;
   std::shared_ptr<cmdlib::CommandFacility> m_cmd_fac;
+  std::shared_ptr<ConfFacility> m_cmd_data_fac;
   std::shared_ptr<ConfigurationManager> m_config_mgr;
+  std::string m_session_name;
+  std::string m_confimpl;
+  bool m_incremental_reconf{ false };
 };
 
 } // namespace appfwk
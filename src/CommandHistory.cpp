@@ -0,0 +1,105 @@
+/**
+ * @file CommandHistory.cpp CommandHistory implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "CommandHistory.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+namespace {
+
+int64_t
+to_epoch_us(std::chrono::system_clock::time_point t)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+nlohmann::json
+CommandRecord::to_json() const
+{
+  nlohmann::json j;
+  j["sequence"] = sequence;
+  j["id"] = id;
+  j["entry_state"] = entry_state;
+  j["exit_state"] = exit_state;
+  j["received_us"] = to_epoch_us(received);
+  j["started_us"] = to_epoch_us(started);
+  j["ended_us"] = to_epoch_us(ended);
+  j["queued_ms"] = std::chrono::duration<double, std::milli>(started - received).count();
+  j["duration_ms"] = std::chrono::duration<double, std::milli>(ended - started).count();
+  j["success"] = success;
+  if (!error.empty())
+    j["error"] = error;
+  j["module_durations_ms"] = module_durations_ms;
+  j["failed_modules"] = failed_modules;
+  return j;
+}
+
+CommandHistory::CommandHistory(size_t capacity)
+  : m_slots(std::max<size_t>(capacity, 1))
+  , m_next_sequence(0)
+{
+}
+
+void
+CommandHistory::record(CommandRecord record)
+{
+  auto entry = std::make_shared<CommandRecord>(std::move(record));
+  std::shared_ptr<const CommandRecord> overwritten; // freed after the lock is released
+  std::lock_guard<std::mutex> lock(m_mutex);
+  entry->sequence = m_next_sequence++;
+  auto& slot = m_slots[entry->sequence % m_slots.size()];
+  overwritten = std::move(slot);
+  slot = std::move(entry);
+}
+
+std::vector<std::shared_ptr<const CommandRecord>>
+CommandHistory::records() const
+{
+  std::vector<std::shared_ptr<const CommandRecord>> result;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    result.reserve(m_slots.size());
+    for (const auto& slot : m_slots) {
+      if (slot)
+        result.push_back(slot);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a->sequence < b->sequence; });
+  return result;
+}
+
+nlohmann::json
+CommandHistory::to_json() const
+{
+  nlohmann::json j = nlohmann::json::array();
+  for (const auto& record : records())
+    j.push_back(record->to_json());
+  return j;
+}
+
+bool
+CommandHistory::dump(const std::string& path) const
+{
+  std::ofstream ofs(path);
+  if (!ofs.is_open())
+    return false;
+  ofs << to_json().dump(2) << std::endl;
+  return ofs.good();
+}
+
+} // namespace appfwk
+} // namespace dunedaq
@@ -0,0 +1,82 @@
+/**
+ * @file CommandHistory.hpp Fixed-size record of the commands executed by an Application
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_COMMANDHISTORY_HPP_
+#define APPFWK_INCLUDE_APPFWK_COMMANDHISTORY_HPP_
+
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+/**
+ * @brief What happened to one command
+ */
+struct CommandRecord
+{
+  uint64_t sequence{ 0 }; ///< Assigned by CommandHistory::record, increasing with every command
+  std::string id;
+  std::string entry_state; ///< Entry state requested by the command
+  std::string exit_state;  ///< State of the application after the command
+  std::chrono::system_clock::time_point received; ///< When the command reached the application
+  std::chrono::system_clock::time_point started;  ///< When it was admitted, after waiting in the queue if any
+  std::chrono::system_clock::time_point ended;
+  bool success{ false };
+  std::string error;
+  std::map<std::string, double> module_durations_ms;
+  std::vector<std::string> failed_modules;
+
+  nlohmann::json to_json() const;
+};
+
+/**
+ * @brief Ring of the most recent CommandRecords
+ *
+ * Every slot holds an immutable record that is replaced as a whole. A small mutex serialises the assignment of the
+ * sequence number with the replacement of the slot, so that a record never overwrites a newer one, and readers only
+ * hold it to copy the slot pointers: records are formatted, and overwritten records freed, outside of it.
+ */
+class CommandHistory
+{
+public:
+  explicit CommandHistory(size_t capacity = 100);
+
+  CommandHistory(const CommandHistory&) = delete;
+  CommandHistory& operator=(const CommandHistory&) = delete;
+
+  size_t capacity() const { return m_slots.size(); }
+
+  // Add a record, overwriting the oldest one if the ring is full
+  void record(CommandRecord record);
+
+  // Records currently in the ring, oldest first
+  std::vector<std::shared_ptr<const CommandRecord>> records() const;
+
+  nlohmann::json to_json() const;
+
+  // Write the records to a file, as a JSON array. Returns false if the file cannot be written.
+  bool dump(const std::string& path) const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::vector<std::shared_ptr<const CommandRecord>> m_slots;
+  uint64_t m_next_sequence;
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_INCLUDE_APPFWK_COMMANDHISTORY_HPP_
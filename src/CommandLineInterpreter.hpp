@@ -53,6 +53,29 @@ public:
       "session,s", bpo::value<std::string>()->required(), "Session name")(
       "commandFacility,c", bpo::value<std::string>()->required(), "CommandFacility URI")(
       "configurationService,d", bpo::value<std::string>()->required(), "Configuration Service URI")(
+      "warmRestart,w", bpo::bool_switch(), "Keep modules and connections resident across scrap")(
+      "incrementalReconf",
+      bpo::bool_switch(),
+      "On reconf, re-read the configuration and only reconfigure the modules whose configuration changed")(
+      "commandQueue,q",
+      bpo::value<size_t>()->default_value(0),
+      "Number of commands accepted while busy, executed in order of arrival")(
+      "historyFile",
+      bpo::value<std::string>()->default_value(""),
+      "File the command history is written to when a command fails and at exit")(
+      "recordCommands",
+      bpo::value<std::string>()->default_value(""),
+      "File every incoming command is recorded to, for replay_commands.py")(
+      "commandTimeout",
+      bpo::value<unsigned>()->default_value(0),
+      "Time in ms after which a running command is cancelled, 0 for no timeout")(
+      "failFast", bpo::bool_switch(), "Cancel a command as soon as one module fails it")(
+      "commandDataService",
+      bpo::value<std::string>()->default_value(""),
+      "ConfFacility URI the data of commands sent without any is taken from, prefetched while idle")(
+      "traceFile",
+      bpo::value<std::string>()->default_value(""),
+      "Chrome trace-event JSON file the timeline of command execution is written to")(
       "help,h", "produce help message");
 
     bpo::variables_map vm;
@@ -73,6 +96,15 @@ public:
     output.session_name = vm["session"].as<std::string>();
     output.command_facility_plugin_name = vm["commandFacility"].as<std::string>();
     output.conf_service_plugin_name = vm["configurationService"].as<std::string>();
+    output.warm_restart = vm["warmRestart"].as<bool>();
+    output.incremental_reconf = vm["incrementalReconf"].as<bool>();
+    output.command_queue_depth = vm["commandQueue"].as<size_t>();
+    output.history_file = vm["historyFile"].as<std::string>();
+    output.record_file = vm["recordCommands"].as<std::string>();
+    output.trace_file = vm["traceFile"].as<std::string>();
+    output.command_data_service = vm["commandDataService"].as<std::string>();
+    output.command_timeout_ms = vm["commandTimeout"].as<unsigned>();
+    output.fail_fast = vm["failFast"].as<bool>();
     return output;
   }
 
@@ -82,6 +114,15 @@ public:
   std::string session_name{ "" };
   std::string command_facility_plugin_name{ "" }; ///< Name of the CommandFacility plugin to load
   std::string conf_service_plugin_name{ "" };     ///< Name of the ConfService plugin to load
+  bool warm_restart{ false };                     ///< Keep modules and connections resident across scrap
+  bool incremental_reconf{ false };               ///< Apply reconf only to the modules whose configuration changed
+  size_t command_queue_depth{ 0 };                ///< Number of commands accepted while busy
+  std::string history_file{ "" };                 ///< File the command history is dumped to
+  std::string record_file{ "" };                  ///< File incoming commands are recorded to
+  std::string trace_file{ "" };                   ///< Chrome trace file of the command execution
+  std::string command_data_service{ "" };         ///< ConfFacility URI of the data of commands sent without any
+  unsigned command_timeout_ms{ 0 };               ///< Time after which a running command is cancelled
+  bool fail_fast{ false };                        ///< Cancel a command as soon as one module fails it
 
   std::vector<std::string> other_options{}; ///< Any other options which were passed and not recognized
 };
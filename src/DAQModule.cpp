@@ -9,19 +9,153 @@
 #include "appfwk/DAQModule.hpp"
 #include "logging/Logging.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace dunedaq::appfwk {
 
+DAQModule::~DAQModule() noexcept
+{
+  cancel_timers();
+}
+
 void
-DAQModule::execute_command(const std::string& cmd_name, const data_t& data)
+DAQModule::execute_command(const std::string& cmd_name, const data_t& data, const CancellationToken& token)
 {
-  if (auto cmd = m_commands.find(cmd_name); cmd != m_commands.end()) {
-      std::invoke(cmd->second, data);
-      return;
+  auto cmd = m_commands.find(cmd_name);
+  bool thread_cmd = false;
+  for (auto& managed : m_threads) {
+    if (managed.stop_cmd == cmd_name || cmd_name == "scrap")
+      managed.thread->stop();
+    thread_cmd = thread_cmd || managed.start_cmd == cmd_name || managed.stop_cmd == cmd_name;
+  }
+  if (cmd == m_commands.end() && !thread_cmd)
+    throw UnknownCommand(ERS_HERE, get_name(), cmd_name);
+  if (cmd_name == "scrap")
+    cancel_timers();
+
+  if (cmd != m_commands.end())
+    std::invoke(cmd->second, data, token);
+
+  for (auto& managed : m_threads) {
+    if (managed.start_cmd == cmd_name)
+      managed.thread->start();
   }
-  throw UnknownCommand(ERS_HERE, get_name(), cmd_name);
+}
+
+ModuleThread&
+DAQModule::register_thread(const std::string& name,
+                           ModuleThread::iteration_t iteration,
+                           const std::string& start_cmd,
+                           const std::string& stop_cmd)
+{
+  auto thread_name = get_name() + "/" + name;
+  for (auto& managed : m_threads) {
+    if (managed.thread->get_name() != thread_name)
+      continue;
+    // Registered again by init when the module is initialised again, after its threads were stopped
+    if (managed.start_cmd != start_cmd || managed.stop_cmd != stop_cmd || managed.thread->running())
+      throw ThreadRegistrationFailed(ERS_HERE, get_name(), name);
+    managed.thread->set_iteration(std::move(iteration));
+    return *managed.thread;
+  }
+
+  auto thread = std::make_shared<ModuleThread>(thread_name, std::move(iteration));
+  register_node(name, thread);
+  m_threads.push_back(ManagedThread{ name, thread, start_cmd, stop_cmd });
+  return *thread;
+}
+
+void
+DAQModule::stop_threads_and_timers() noexcept
+{
+  for (auto& managed : m_threads)
+    managed.thread->stop();
+  cancel_timers();
+}
+
+std::vector<std::string>
+DAQModule::running_threads() const
+{
+  std::vector<std::string> names;
+  for (const auto& managed : m_threads) {
+    if (managed.thread->running())
+      names.push_back(managed.name);
+  }
+  return names;
+}
+
+void
+DAQModule::start_threads(const std::vector<std::string>& names)
+{
+  for (auto& managed : m_threads) {
+    if (std::find(names.begin(), names.end(), managed.name) != names.end())
+      managed.thread->start();
+  }
+}
+
+TimerService::timer_id_t
+DAQModule::schedule_periodic(const std::string& name,
+                             std::chrono::milliseconds period,
+                             TimerService::callback_t callback)
+{
+  return add_timer(timer_service().schedule_periodic(get_name() + "/" + name, period, std::move(callback)));
+}
+
+TimerService::timer_id_t
+DAQModule::schedule_once(const std::string& name, std::chrono::milliseconds delay, TimerService::callback_t callback)
+{
+  return add_timer(timer_service().schedule_once(get_name() + "/" + name, delay, std::move(callback)));
+}
+
+bool
+DAQModule::cancel_timer(TimerService::timer_id_t id)
+{
+  {
+    const std::lock_guard<std::mutex> lock(m_timers_mutex);
+    auto it = std::find(m_timers.begin(), m_timers.end(), id);
+    if (it == m_timers.end())
+      return false;
+    m_timers.erase(it);
+  }
+  return m_timer_service->cancel(id);
+}
+
+TimerService&
+DAQModule::timer_service()
+{
+  const std::lock_guard<std::mutex> lock(m_timers_mutex);
+  if (m_timer_service == nullptr)
+    m_timer_service = get_timer_service();
+  return *m_timer_service;
+}
+
+TimerService::timer_id_t
+DAQModule::add_timer(TimerService::timer_id_t id)
+{
+  const std::lock_guard<std::mutex> lock(m_timers_mutex);
+  // Forget the one-shot timers which already ran, so that the list does not grow
+  m_timers.erase(std::remove_if(m_timers.begin(),
+                                m_timers.end(),
+                                [this](TimerService::timer_id_t t) { return !m_timer_service->scheduled(t); }),
+                 m_timers.end());
+  m_timers.push_back(id);
+  return id;
+}
+
+void
+DAQModule::cancel_timers()
+{
+  std::vector<TimerService::timer_id_t> timers;
+  {
+    const std::lock_guard<std::mutex> lock(m_timers_mutex);
+    timers.swap(m_timers);
+  }
+  for (auto id : timers)
+    m_timer_service->cancel(id);
 }
 
 std::vector<std::string>
@@ -30,6 +164,12 @@ DAQModule::get_commands() const
   std::vector<std::string> cmds;
   for (const auto& [key, value] : m_commands)
     cmds.push_back(key);
+  for (const auto& managed : m_threads) {
+    for (const auto& cmd : { managed.start_cmd, managed.stop_cmd }) {
+      if (std::find(cmds.begin(), cmds.end(), cmd) == cmds.end())
+        cmds.push_back(cmd);
+    }
+  }
   return cmds;
 }
 
@@ -39,6 +179,10 @@ DAQModule::has_command(const std::string& cmd_name) const
   if (auto cmd = m_commands.find(cmd_name); cmd != m_commands.end()) {
       return true;
   }
+  for (const auto& managed : m_threads) {
+    if (managed.start_cmd == cmd_name || managed.stop_cmd == cmd_name)
+      return true;
+  }
   return false;
 }
 
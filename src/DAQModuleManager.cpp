@@ -20,13 +20,21 @@
 #include "confmodel/DaqModulesGroupByType.hpp"
 #include "confmodel/Session.hpp"
 
+#include "conffwk/ConfigObject.hpp"
+#include "conffwk/Configuration.hpp"
+#include "conffwk/Schema.hpp"
+
 #include "iomanager/IOManager.hpp"
 
 #include "logging/Logging.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <future>
 #include <map>
 #include <regex>
+#include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,23 +42,136 @@
 namespace dunedaq {
 namespace appfwk {
 
+namespace {
+
+int64_t
+steady_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+std::string
+dal_fingerprint(const conffwk::DalObject* obj)
+{
+  std::ostringstream os;
+  obj->print(0, false, os);
+  return os.str();
+}
+
+// Appends the attributes and references of obj, then of every object reachable through its relationships, once each
+void
+append_closure(conffwk::Configuration& confdb,
+               conffwk::ConfigObject obj,
+               std::set<std::string>& visited,
+               std::string& fingerprint)
+{
+  if (obj.is_null() || !visited.insert(obj.class_name() + "@" + obj.UID()).second) {
+    return;
+  }
+  std::ostringstream os;
+  obj.print_ref(os, confdb);
+  fingerprint += os.str();
+
+  for (const auto& relationship : confdb.get_class_info(obj.class_name()).p_relationships) {
+    std::vector<conffwk::ConfigObject> related;
+    if (relationship.p_cardinality == conffwk::zero_or_many || relationship.p_cardinality == conffwk::one_or_many) {
+      obj.get(relationship.p_name, related);
+    } else {
+      conffwk::ConfigObject single;
+      obj.get(relationship.p_name, single);
+      related.push_back(single);
+    }
+    for (auto& object : related) {
+      append_closure(confdb, object, visited, fingerprint);
+    }
+  }
+}
+
+// A module's fingerprint covers its DAL object and everything it references, directly or not: its connections, but
+// also the objects holding parts of its configuration
+std::map<std::string, std::string>
+module_fingerprints(ModuleConfiguration& mcfg)
+{
+  auto& confdb = mcfg.configuration_manager()->confdb();
+  std::map<std::string, std::string> fingerprints;
+  for (auto mod : mcfg.modules()) {
+    std::set<std::string> visited;
+    std::string fingerprint;
+    append_closure(confdb, mod->config_object(), visited, fingerprint);
+    fingerprints[mod->UID()] = fingerprint;
+  }
+  return fingerprints;
+}
+
+std::set<std::string>
+connection_fingerprints(ModuleConfiguration& mcfg)
+{
+  std::set<std::string> fingerprints;
+  for (auto queue : mcfg.queues()) {
+    fingerprints.insert(dal_fingerprint(queue));
+  }
+  for (auto netcon : mcfg.networkconnections()) {
+    fingerprints.insert(dal_fingerprint(netcon));
+  }
+  return fingerprints;
+}
+
+} // namespace
+
 DAQModuleManager::DAQModuleManager()
   : m_initialized(false)
+  , m_warm_restart(false)
+  , m_iomanager_resident(false)
 {
 }
 
+DAQModuleManager::~DAQModuleManager()
+{
+  release_modules(m_module_map);
+}
+
 void
 DAQModuleManager::initialize(std::shared_ptr<ConfigurationManager> cfgMgr, opmonlib::OpMonManager& opm)
+{
+  {
+    TraceRecorder::Scope trace(m_trace, "init", "command");
+    initialize_modules(cfgMgr, opm);
+  }
+  m_trace.flush();
+}
+
+void
+DAQModuleManager::initialize_modules(std::shared_ptr<ConfigurationManager> cfgMgr, opmonlib::OpMonManager& opm)
 {
   m_module_configuration = std::make_shared<ModuleConfiguration>(cfgMgr);
-  get_iomanager()->configure(cfgMgr->session()->UID(),
-                             m_module_configuration->queues(),
-                             m_module_configuration->networkconnections(),
-                             m_module_configuration->connectivity_service(),
-                             opm);
+
+  auto connections = connection_fingerprints(*m_module_configuration);
+  if (m_warm_restart && m_iomanager_resident && connections == m_resident_connections) {
+    TLOG_DEBUG(1) << "Warm restart: connections unchanged, keeping the IOManager configuration";
+  } else {
+    if (m_iomanager_resident) {
+      get_iomanager()->reset();
+    }
+    get_iomanager()->configure(cfgMgr->session()->UID(),
+                               m_module_configuration->queues(),
+                               m_module_configuration->networkconnections(),
+                               m_module_configuration->connectivity_service(),
+                               opm);
+  }
+  m_iomanager_resident = m_warm_restart;
+  m_resident_connections = connections;
+
   init_modules(m_module_configuration->modules(), opm);
+  m_running = false;
+  validate_action_plans(*m_module_configuration);
+  this->m_initialized = true;
+}
 
-  for (auto& plan_pair : m_module_configuration->action_plans()) {
+void
+DAQModuleManager::validate_action_plans(ModuleConfiguration& mcfg)
+{
+  for (auto& plan_pair : mcfg.action_plans()) {
     auto cmd = plan_pair.first;
 
     for (auto& step : plan_pair.second->get_steps()) {
@@ -69,7 +190,6 @@ DAQModuleManager::initialize(std::shared_ptr<ConfigurationManager> cfgMgr, opmon
       }
     }
   }
-  this->m_initialized = true;
 }
 
 void
@@ -110,9 +230,31 @@ void
 DAQModuleManager::init_modules(const std::vector<const dunedaq::confmodel::DaqModule*>& modules,
                                opmonlib::OpMonManager& opm)
 {
+  // In warm restart mode, modules left resident by a previous initialization are re-initialised in place
+  DAQModuleMap_t resident_modules;
+  if (m_warm_restart) {
+    resident_modules.swap(m_module_map);
+  }
+  release_modules(m_module_map);
+  auto resident_types = std::move(m_modules_by_type);
+  m_modules_by_type.clear();
+  m_module_configurations.clear();
+
   for (const auto mod : modules) {
-    TLOG_DEBUG(0) << "construct: " << mod->class_name() << " : " << mod->UID();
-    auto mptr = make_module(mod->class_name(), mod->UID());
+    std::shared_ptr<DAQModule> mptr;
+    auto resident = resident_modules.find(mod->UID());
+    auto& resident_of_type = resident_types[mod->class_name()];
+    if (resident != resident_modules.end() &&
+        std::find(resident_of_type.begin(), resident_of_type.end(), mod->UID()) != resident_of_type.end()) {
+      TLOG_DEBUG(0) << "reuse: " << mod->class_name() << " : " << mod->UID();
+      mptr = resident->second;
+      resident_modules.erase(resident);
+      mptr->stop_threads_and_timers();
+    } else {
+      TLOG_DEBUG(0) << "construct: " << mod->class_name() << " : " << mod->UID();
+      mptr = make_module(mod->class_name(), mod->UID());
+      opm.register_node(mod->UID(), mptr);
+    }
     m_module_map.emplace(mod->UID(), mptr);
 
     if (!m_modules_by_type.count(mod->class_name())) {
@@ -120,59 +262,249 @@ DAQModuleManager::init_modules(const std::vector<const dunedaq::confmodel::DaqMo
     }
     m_modules_by_type[mod->class_name()].emplace_back(mod->UID());
 
-    opm.register_node(mod->UID(), mptr);
+    m_module_configurations[mod->UID()] = m_module_configuration;
     mptr->init(m_module_configuration);
   }
+  // Resident modules which are not part of the new configuration
+  release_modules(resident_modules);
+}
+
+void
+DAQModuleManager::release_modules(DAQModuleMap_t& modules)
+{
+  // The DAQModule destructor runs after the derived class is destroyed, so threads and timers which may still call
+  // into it are stopped first
+  for (auto& [name, mptr] : modules) {
+    mptr->stop_threads_and_timers();
+  }
+  modules.clear();
 }
 
 void
 DAQModuleManager::cleanup()
 {
-  get_iomanager()->reset();
+  if (!m_warm_restart) {
+    get_iomanager()->reset();
+  }
   this->m_initialized = false;
 }
 
-DAQModuleManager::dataobj_t
-DAQModuleManager::get_dataobj_for_module(const std::string& mod_name, const dataobj_t& cmd_data)
+std::vector<std::string>
+DAQModuleManager::reconfigure(std::shared_ptr<ConfigurationManager> cfgMgr, const dataobj_t& conf_data)
 {
-  auto cmd_obj = cmd_data.get<cmd::CmdObj>();
-  const dataobj_t dummy{};
+  if (!m_initialized) {
+    throw DAQModuleManagerNotInitialized(ERS_HERE, "reconfigure");
+  }
 
-  if (!cmd_obj.modules.empty()) {
-    for (const auto& addressed : cmd_obj.modules) {
+  auto new_configuration = std::make_shared<ModuleConfiguration>(cfgMgr);
 
-      // First exception: empty = `all`
-      if (addressed.match.empty()) {
-        return addressed.data;
-      } else {
-        // match module name with regex
-        if (std::regex_match(mod_name, std::regex(addressed.match))) {
-          return addressed.data;
-        }
+  std::map<std::string, std::string> current_classes;
+  for (auto mod : m_module_configuration->modules()) {
+    current_classes[mod->UID()] = mod->class_name();
+  }
+  for (auto mod : new_configuration->modules()) {
+    auto current_class = current_classes.find(mod->UID());
+    if (current_class == current_classes.end()) {
+      throw IncrementalReconfigurationNotPossible(ERS_HERE, "module " + mod->UID() + " was added");
+    }
+    if (current_class->second != mod->class_name()) {
+      throw IncrementalReconfigurationNotPossible(ERS_HERE, "module " + mod->UID() + " changed class");
+    }
+  }
+  if (current_classes.size() != new_configuration->modules().size()) {
+    throw IncrementalReconfigurationNotPossible(ERS_HERE, "modules were removed");
+  }
+  if (connection_fingerprints(*m_module_configuration) != connection_fingerprints(*new_configuration)) {
+    throw IncrementalReconfigurationNotPossible(ERS_HERE, "queues or network connections changed");
+  }
+
+  auto current = module_fingerprints(*m_module_configuration);
+  auto updated = module_fingerprints(*new_configuration);
+  std::vector<std::string> changed;
+  for (auto mod : new_configuration->modules()) {
+    if (current[mod->UID()] != updated[mod->UID()]) {
+      changed.push_back(mod->UID());
+    }
+  }
+  TLOG_DEBUG(1) << "Incremental reconfiguration touches " << changed.size() << " of " << updated.size()
+                << " modules";
+
+  // The modules are the same, only the action plans can make the new configuration invalid
+  validate_action_plans(*new_configuration);
+  m_module_configuration = new_configuration;
+  // Only the changed modules switch to the new configuration, the previous one is released once no module uses it
+  for (auto& mod_name : changed) {
+    m_module_configurations[mod_name] = new_configuration;
+  }
+
+  auto addressed_data = index_addressed_data("reconf", conf_data);
+  // Running modules are stopped first and started again with the data of the last start command
+  auto start_addressed_data = index_addressed_data("start", m_start_data);
+  std::string failed_mod_names("");
+  {
+    TraceRecorder::Scope trace(m_trace, "reconf", "command", { { "modules", changed }, { "running", m_running } });
+    std::unordered_map<std::string, std::future<bool>> futures;
+    for (auto& mod_name : changed) {
+      const auto& data_obj = get_dataobj_for_module(mod_name, addressed_data);
+      const auto* start_data = m_running ? &get_dataobj_for_module(mod_name, start_addressed_data) : nullptr;
+      futures[mod_name] = std::async(
+        std::launch::async, &DAQModuleManager::reconfigure_module, this, mod_name, std::cref(data_obj), start_data);
+    }
+    for (auto& future : futures) {
+      if (!future.second.get()) {
+        failed_mod_names.append(future.first);
+        failed_mod_names.append(", ");
+      }
+    }
+  }
+  m_trace.flush();
+  if (!failed_mod_names.empty()) {
+    throw CommandDispatchingFailed(ERS_HERE, "reconfigure", failed_mod_names);
+  }
+  return changed;
+}
+
+bool
+DAQModuleManager::reconfigure_module(const std::string& mod_name,
+                                     const dataobj_t& conf_data,
+                                     const dataobj_t* start_data)
+{
+  auto& mptr = m_module_map.at(mod_name);
+  m_trace.name_thread(mod_name);
+  // Every step is recorded like a module action, so that the trace shows the scrap/init/conf sequence
+  auto run_step = [&](const std::string& step, const std::function<void()>& action) {
+    TraceRecorder::Scope trace(m_trace, mod_name, "module", { { "command", step } });
+    action();
+  };
+
+  try {
+    TLOG_DEBUG(2) << "Reconfiguring " << mod_name;
+    // Managed threads are stopped by stop and scrap, and restarted once the module is configured (and started)
+    // again
+    auto running_threads = mptr->running_threads();
+    if (start_data != nullptr && mptr->has_command("stop")) {
+      run_step("stop", [&]() { mptr->execute_command("stop", dataobj_t::object()); });
+    }
+    if (mptr->has_command("scrap")) {
+      run_step("scrap", [&]() { mptr->execute_command("scrap"); });
+    }
+    mptr->stop_threads_and_timers();
+    run_step("init", [&]() { mptr->init(m_module_configuration); });
+    if (mptr->has_command("conf")) {
+      run_step("conf", [&]() { mptr->execute_command("conf", conf_data); });
+    }
+    if (start_data != nullptr && mptr->has_command("start")) {
+      run_step("start", [&]() { mptr->execute_command("start", *start_data); });
+    }
+    mptr->start_threads(running_threads);
+  } catch (ers::Issue& ex) {
+    ers::error(ex);
+    return false;
+  }
+  return true;
+}
+
+DAQModuleManager::AddressedDataList_t
+DAQModuleManager::index_addressed_data(const std::string& cmd, const dataobj_t& cmd_data)
+{
+  // Walk the modules array of the CmdObj in place rather than converting it to cmd::CmdObj, which would copy the
+  // data of every AddressedCmd. Like the conversion, this accepts no data at all and a CmdObj without modules, and
+  // rejects anything not following the schema.
+  AddressedDataList_t addressed_data;
+  if (cmd_data.is_null()) {
+    return addressed_data;
+  }
+  if (!cmd_data.is_object()) {
+    throw MalformedCommandData(ERS_HERE, cmd, "", "not an object");
+  }
+  auto modules = cmd_data.find("modules");
+  if (modules == cmd_data.end()) {
+    return addressed_data;
+  }
+  if (!modules->is_array()) {
+    throw MalformedCommandData(ERS_HERE, cmd, "", "modules is not an array");
+  }
+
+  static const dataobj_t s_no_data{};
+  addressed_data.reserve(modules->size());
+  for (const auto& addressed : *modules) {
+    auto match = addressed.is_object() ? addressed.find("match") : addressed.end();
+    if (match == addressed.end() || !match->is_string()) {
+      throw MalformedCommandData(ERS_HERE, cmd, "", "no match string in " + addressed.dump());
+    }
+    auto data = addressed.find("data");
+    const auto& match_str = match->get_ref<const std::string&>();
+    try {
+      addressed_data.push_back({ match_str, std::regex(match_str), data != addressed.end() ? &(*data) : &s_no_data });
+    } catch (const std::regex_error& ex) {
+      throw MalformedCommandData(ERS_HERE, cmd, "", "invalid match " + match_str + ": " + ex.what());
+    }
+  }
+  return addressed_data;
+}
+
+const DAQModuleManager::dataobj_t&
+DAQModuleManager::get_dataobj_for_module(const std::string& mod_name, const AddressedDataList_t& addressed_data)
+{
+  static const dataobj_t s_dummy{};
+
+  for (const auto& addressed : addressed_data) {
+
+    // First exception: empty = `all`
+    if (addressed.match.empty()) {
+      return *addressed.data;
+    } else {
+      // match module name with regex
+      if (std::regex_match(mod_name, addressed.match_re)) {
+        return *addressed.data;
       }
     }
   }
   // No matches
-  return dummy;
+  return s_dummy;
 }
 
 bool
 DAQModuleManager::execute_action(const std::string& module_name, const std::string& action, const dataobj_t& data_obj)
 {
+  CommandProgress::ModuleProgress* module_progress = nullptr;
+  auto progress = std::atomic_load(&m_progress);
+  if (progress != nullptr && progress->command == action) {
+    auto it = progress->modules.find(module_name);
+    if (it != progress->modules.end())
+      module_progress = &it->second;
+  }
+
+  auto cancellation = std::atomic_load(&m_cancellation);
+  auto token = cancellation != nullptr ? cancellation->token() : CancellationToken();
+
+  bool success = true;
+  m_trace.name_thread(module_name);
+  auto start_ns = steady_now_ns();
+  if (module_progress != nullptr)
+    module_progress->start_ns.store(start_ns);
   try {
     TLOG_DEBUG(2) << "Executing " << module_name << " -> " << action;
-    m_module_map[module_name]->execute_command(action, data_obj);
+    m_module_map[module_name]->execute_command(action, data_obj, token);
   } catch (ers::Issue& ex) {
     ers::error(ex);
-    return false;
+    success = false;
+    if (m_fail_fast && cancellation != nullptr)
+      cancellation->request_stop("module " + module_name + " failed");
   }
-  return true;
+  auto end_ns = steady_now_ns();
+  if (module_progress != nullptr) {
+    module_progress->failed.store(!success);
+    module_progress->end_ns.store(end_ns);
+  }
+  m_trace.record(module_name, "module", start_ns, end_ns, { { "command", action }, { "success", success } });
+  return success;
 }
 
 void
 DAQModuleManager::execute_action_plan_step(std::string const& cmd,
                                            const confmodel::DaqModulesGroup* step,
-                                           const dataobj_t& cmd_data,
+                                           const AddressedDataList_t& addressed_data,
                                            bool execution_mode_is_serial)
 {
   std::string failed_mod_names("");
@@ -184,31 +516,31 @@ DAQModuleManager::execute_action_plan_step(std::string const& cmd,
     for (auto& mod_class : byType->get_modules()) {
       auto modules = m_modules_by_type[mod_class];
       for (auto& mod_name : modules) {
-        auto data_obj = get_dataobj_for_module(mod_name, cmd_data);
+        const auto& data_obj = get_dataobj_for_module(mod_name, addressed_data);
         TLOG_DEBUG(1) << "Executing action " << cmd << " on module " << mod_name << " (class " << mod_class << ")";
-        futures[mod_name] =
-          std::async(std::launch::async, &DAQModuleManager::execute_action, this, mod_name, cmd, data_obj);
+        futures[mod_name] = std::async(
+          std::launch::async, &DAQModuleManager::execute_action, this, mod_name, cmd, std::cref(data_obj));
         if (execution_mode_is_serial)
-          futures[mod_name].wait();
+          wait_for_action(cmd, futures[mod_name]);
       }
     }
   } else if (byMod != nullptr) {
     for (auto& mod : byMod->get_modules()) {
       auto mod_name = mod->UID();
-      auto data_obj = get_dataobj_for_module(mod_name, cmd_data);
+      const auto& data_obj = get_dataobj_for_module(mod_name, addressed_data);
       TLOG_DEBUG(1) << "Executing action " << cmd << " on module " << mod_name << " (class " << mod->class_name()
                     << ")";
       futures[mod_name] =
-        std::async(std::launch::async, &DAQModuleManager::execute_action, this, mod_name, cmd, data_obj);
+        std::async(std::launch::async, &DAQModuleManager::execute_action, this, mod_name, cmd, std::cref(data_obj));
       if (execution_mode_is_serial)
-        futures[mod_name].wait();
+        wait_for_action(cmd, futures[mod_name]);
     }
   } else {
     throw CommandDispatchingFailed(ERS_HERE, cmd, "Could not get DaqModulesGroup!");
   }
 
   for (auto& future : futures) {
-    future.second.wait();
+    wait_for_action(cmd, future.second);
     auto ret = future.second.get();
     if (!ret) {
       failed_mod_names.append(future.first);
@@ -221,6 +553,26 @@ DAQModuleManager::execute_action_plan_step(std::string const& cmd,
   }
 }
 
+void
+DAQModuleManager::wait_for_action(const std::string& cmd, std::future<bool>& action)
+{
+  if (m_command_timeout.count() > 0 && action.wait_until(m_command_deadline) == std::future_status::timeout) {
+    auto cancellation = std::atomic_load(&m_cancellation);
+    auto reason = "timeout after " + std::to_string(m_command_timeout.count()) + " ms";
+    if (cancellation != nullptr && cancellation->request_stop(reason)) {
+      ers::warning(CommandTimedOut(ERS_HERE, cmd, m_command_timeout.count()));
+    }
+  }
+  action.wait();
+}
+
+bool
+DAQModuleManager::abort(const std::string& reason)
+{
+  auto cancellation = std::atomic_load(&m_cancellation);
+  return cancellation != nullptr && cancellation->request_stop(reason);
+}
+
 std::vector<std::string>
 DAQModuleManager::get_modnames_by_cmdid(cmdlib::cmd::CmdId id)
 {
@@ -235,7 +587,7 @@ DAQModuleManager::get_modnames_by_cmdid(cmdlib::cmd::CmdId id)
 }
 
 void
-DAQModuleManager::check_cmd_data(const std::string& id, const dataobj_t& cmd_data)
+DAQModuleManager::check_cmd_data(const std::string& id, const AddressedDataList_t& addressed_data)
 {
   // This method ensures that each module is only matched once per command.
   // If multiple matches are found, an ers::Issue is thrown
@@ -243,22 +595,19 @@ DAQModuleManager::check_cmd_data(const std::string& id, const dataobj_t& cmd_dat
   // multiple-matches detection logic. The author is painfully aware that it can be
   // vastly improved, in style if not in performance.
 
-  auto cmd_obj = cmd_data.get<cmd::CmdObj>();
-  const dataobj_t dummy{};
-
   // Make a convenience array with module names that have the requested command
   std::vector<std::string> cmd_mod_names = get_modnames_by_cmdid(id);
 
   // containers for error tracking
   std::map<std::string, std::vector<std::string>> mod_to_re;
 
-  if (!cmd_obj.modules.empty()) {
-    for (const auto& addressed : cmd_obj.modules) {
+  if (!addressed_data.empty()) {
+    for (const auto& addressed : addressed_data) {
       if (!addressed.match.empty()) {
         // Find module names matching the regex
         for (const std::string& mod_name : cmd_mod_names) {
           // match module name with regex
-          if (std::regex_match(mod_name, std::regex(addressed.match))) {
+          if (std::regex_match(mod_name, addressed.match_re)) {
             mod_to_re[mod_name].push_back(addressed.match);
           }
         }
@@ -295,9 +644,58 @@ DAQModuleManager::execute(const std::string& cmd, const dataobj_t& cmd_data)
     throw DAQModuleManagerNotInitialized(ERS_HERE, cmd);
   }
 
-  check_cmd_data(cmd, cmd_data);
+  auto addressed_data = index_addressed_data(cmd, cmd_data);
+  check_cmd_data(cmd, addressed_data);
 
   auto action_plan = m_module_configuration->action_plan(cmd);
+
+  auto progress = std::make_shared<CommandProgress>();
+  progress->command = cmd;
+  progress->start_time = std::chrono::steady_clock::now();
+  if (action_plan != nullptr) {
+    for (auto& step : action_plan->get_steps())
+      progress->steps.push_back(step->UID());
+  }
+  for (auto& mod_name : get_modnames_by_cmdid(cmd))
+    progress->modules[mod_name];
+  std::atomic_store(&m_progress, progress);
+
+  m_command_deadline = progress->start_time + m_command_timeout;
+  std::atomic_store(&m_cancellation, std::make_shared<CancellationSource>());
+
+  try {
+    TraceRecorder::Scope trace(m_trace, cmd, "command");
+    execute_action_plan(cmd, action_plan, addressed_data, *progress);
+  } catch (...) {
+    progress->end_ns.store(steady_now_ns());
+    std::atomic_store(&m_cancellation, std::shared_ptr<CancellationSource>());
+    m_trace.flush();
+    throw;
+  }
+  progress->end_ns.store(steady_now_ns());
+  std::atomic_store(&m_cancellation, std::shared_ptr<CancellationSource>());
+  m_trace.flush();
+
+  // Remembered for incremental reconfiguration, which starts running modules again after reconfiguring them
+  if (cmd == "start") {
+    m_running = true;
+    m_start_data = cmd_data;
+  } else if (cmd == "stop" || cmd == "scrap") {
+    m_running = false;
+  }
+
+  // Shutdown IOManager at scrap, unless it is kept resident for a warm restart
+  if (cmd == "scrap" && !m_warm_restart) {
+    get_iomanager()->shutdown();
+  }
+}
+
+void
+DAQModuleManager::execute_action_plan(const std::string& cmd,
+                                      const confmodel::ActionPlan* action_plan,
+                                      const AddressedDataList_t& addressed_data,
+                                      CommandProgress& progress)
+{
   if (action_plan == nullptr) {
 #if 0
     throw ActionPlanNotFound(ERS_HERE, cmd, "Throwing exception");
@@ -313,12 +711,13 @@ DAQModuleManager::execute(const std::string& cmd, const dataobj_t& cmd_data)
     auto mods = get_modnames_by_cmdid(cmd);
     for (auto& mod : mods) {
       TLOG_DEBUG(1) << "Executing action " << cmd << " on module " << mod;
-      auto data_obj = get_dataobj_for_module(mod, cmd_data);
-      futures[mod] = std::async(std::launch::async, &DAQModuleManager::execute_action, this, mod, cmd, data_obj);
+      const auto& data_obj = get_dataobj_for_module(mod, addressed_data);
+      futures[mod] =
+        std::async(std::launch::async, &DAQModuleManager::execute_action, this, mod, cmd, std::cref(data_obj));
     }
 
     for (auto& future : futures) {
-      future.second.wait();
+      wait_for_action(cmd, future.second);
       auto ret = future.second.get();
       if (!ret) {
         failed_mod_names.append(future.first);
@@ -335,15 +734,52 @@ DAQModuleManager::execute(const std::string& cmd, const dataobj_t& cmd_data)
     auto serial_execution = execution_policy == "modules-in-series";
 
     // We validated the action plans already
+    size_t step_index = 0;
     for (auto& step : action_plan->get_steps()) {
-      execute_action_plan_step(cmd, step, cmd_data, serial_execution);
+      TraceRecorder::Scope trace(m_trace, step->UID(), "step", { { "command", cmd }, { "index", step_index } });
+      progress.current_step.store(step_index++);
+      execute_action_plan_step(cmd, step, addressed_data, serial_execution);
     }
   }
+}
 
-  // Shutdown IOManager at scrap
-  if (cmd == "scrap") {
-    get_iomanager()->shutdown();
+DAQModuleManager::dataobj_t
+DAQModuleManager::CommandProgress::to_json() const
+{
+  auto now = steady_now_ns();
+  auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(start_time.time_since_epoch()).count();
+  auto end = end_ns.load();
+
+  dataobj_t result;
+  result["command"] = command;
+  result["running"] = end == 0;
+  result["elapsed_ms"] = ((end == 0 ? now : end) - start) / 1e6;
+  if (!steps.empty()) {
+    auto step = current_step.load();
+    result["step"] = steps[step];
+    result["step_index"] = step;
+    result["step_count"] = steps.size();
+  }
+
+  dataobj_t in_flight = dataobj_t::array();
+  for (const auto& [name, module] : modules) {
+    auto mod_start = module.start_ns.load();
+    auto mod_end = module.end_ns.load();
+    dataobj_t entry;
+    if (mod_start == 0) {
+      entry["status"] = "pending";
+    } else if (mod_end == 0) {
+      entry["status"] = "running";
+      in_flight.push_back(name);
+    } else {
+      entry["status"] = module.failed.load() ? "failed" : "done";
+    }
+    if (mod_start != 0)
+      entry["elapsed_ms"] = ((mod_end == 0 ? now : mod_end) - mod_start) / 1e6;
+    result["modules"][name] = entry;
   }
+  result["in_flight"] = in_flight;
+  return result;
 }
 
 } // namespace appfwk
@@ -12,6 +12,9 @@
 #include "ers/Issue.hpp"
 #include "nlohmann/json.hpp"
 
+#include "TraceRecorder.hpp"
+
+#include "appfwk/CancellationToken.hpp"
 #include "appfwk/ConfigurationManager.hpp"
 #include "appfwk/ModuleConfiguration.hpp"
 #include "confmodel/DaqModule.hpp"
@@ -20,8 +23,14 @@
 #include "cmdlib/cmd/Structs.hpp"
 #include "opmonlib/OpMonManager.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
 #include <map>
 #include <memory>
+#include <regex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -45,6 +54,14 @@ ERS_DECLARE_ISSUE(appfwk,
                   ((std::string)modules)                                                ///< Message parameters
 )
 
+ERS_DECLARE_ISSUE_BASE(appfwk,                                               ///< Namespace
+                       MalformedCommandData,                                 ///< Issue class name
+                       CommandDispatchingFailed,                             ///< Base Issue class name
+                       "Malformed data of command " << cmdid << ": " << reason, ///< Message
+                       ((std::string)cmdid)((std::string)modules),           ///< Base Issue params
+                       ((std::string)reason)                                 ///< This class params
+)
+
 ERS_DECLARE_ISSUE(appfwk,                                                                ///< Namespace
                   ConflictingCommandMatching,                                            ///< Issue class name
                   "Command " << cmdid << " matches multiple times modules: " << modules, ///< Message
@@ -66,6 +83,21 @@ ERS_DECLARE_ISSUE_BASE(appfwk,
                        ((std::string)message)                                          ///< This class params
 )
 
+ERS_DECLARE_ISSUE(appfwk,                                                                       ///< Namespace
+                  IncrementalReconfigurationNotPossible,                                        ///< Issue class name
+                  "Configuration cannot be applied incrementally, a full scrap/init/conf cycle is needed: "
+                    << reason,        ///< Message
+                  ((std::string)reason) ///< Message parameters
+)
+
+ERS_DECLARE_ISSUE(appfwk,          ///< Namespace
+                  CommandTimedOut, ///< Issue class name
+                  "Command " << cmdid << " still running after " << timeout_ms
+                             << " ms, cancelling it", ///< Message
+                  ((std::string)cmdid)                ///< Message parameters
+                  ((int64_t)timeout_ms)               ///< Message parameters
+)
+
 // Re-enable coverage collection LCOV_EXCL_STOP
 
 namespace appfwk {
@@ -78,33 +110,164 @@ public:
   using dataobj_t = nlohmann::json;
 
   DAQModuleManager();
+  ~DAQModuleManager();
 
   void initialize(std::shared_ptr<ConfigurationManager> mgr, opmonlib::OpMonManager & );
   bool initialized() const { return m_initialized; }
   void cleanup();
 
+  /**
+   * @brief Keep modules, plugin libraries and the IOManager resident across scrap/cleanup
+   *
+   * In warm restart mode, scrap and cleanup leave the IOManager configured, and a following initialize re-initialises
+   * the existing module instances in place instead of constructing new ones. The IOManager is only reconfigured if
+   * the queues or network connections changed, so a warm init/conf cycle costs only the reconfiguration itself.
+   */
+  void set_warm_restart(bool warm_restart) { m_warm_restart = warm_restart; }
+  bool warm_restart() const { return m_warm_restart; }
+
+  /**
+   * @brief Write a timeline of command execution to a Chrome trace-event JSON file, empty to stop
+   *
+   * Every initialization, command, action plan step and module action becomes an event with its begin time,
+   * duration and thread, so that the file opened in Perfetto shows how modules overlap within a step.
+   */
+  void set_trace_file(const std::string& path, const std::string& process_name = "")
+  {
+    m_trace.open(path, process_name);
+  }
+
+  /**
+   * @brief Cancel the token of commands still running after the given time, zero (the default) for no timeout
+   *
+   * Cancellation is cooperative: the command still waits for every module to return, modules which registered
+   * their handlers with a CancellationToken are expected to give up quickly.
+   */
+  void set_command_timeout(std::chrono::milliseconds timeout) { m_command_timeout = timeout; }
+
+  /// Cancel the token of the command as soon as one module fails it
+  void set_fail_fast(bool fail_fast) { m_fail_fast = fail_fast; }
+
+  /**
+   * @brief Cancel the token of the command being executed, can be called from any thread
+   * @returns false if no command is being executed or it was already cancelled
+   */
+  bool abort(const std::string& reason);
+
   // Execute a properly structured command
   void execute(const std::string& cmd, const dataobj_t& cmd_data);
 
+  /**
+   * @brief Apply a new configuration, touching only the modules whose configuration changed
+   * @param mgr ConfigurationManager holding the new configuration
+   * @param conf_data Data of the "conf" command run on the changed modules
+   * @return Names of the modules that were reconfigured
+   *
+   * Modules whose DAL object, or any object it references directly or indirectly, differs from the current
+   * configuration are scrapped, re-initialised with the new ModuleConfiguration and configured again; all other
+   * modules are left untouched. The set of modules and of connections (and thus the IOManager configuration) must be
+   * unchanged and the new action plans valid, otherwise an issue is thrown and the current configuration is kept.
+   * During a run, the changed modules are stopped first and started again at the end with the data of the last
+   * start command. Managed threads of a changed module which were running are running again afterwards.
+   */
+  std::vector<std::string> reconfigure(std::shared_ptr<ConfigurationManager> mgr, const dataobj_t& conf_data);
+
+  /**
+   * @brief Progress of the command being (or last) executed
+   *
+   * A new snapshot is published at the start of every command and updated in place while the command runs, only
+   * through atomics, so it can be read from any thread without blocking execute().
+   */
+  struct CommandProgress
+  {
+    struct ModuleProgress
+    {
+      std::atomic<int64_t> start_ns{ 0 }; ///< steady_clock time the module started the command, 0 if not yet
+      std::atomic<int64_t> end_ns{ 0 };   ///< steady_clock time the module finished the command, 0 if not yet
+      std::atomic<bool> failed{ false };
+    };
+
+    std::string command;
+    std::chrono::steady_clock::time_point start_time;
+    std::vector<std::string> steps; ///< Action plan steps, empty if the command has no action plan
+    std::atomic<size_t> current_step{ 0 };
+    std::atomic<int64_t> end_ns{ 0 }; ///< steady_clock time the command finished, 0 while it is running
+    std::map<std::string, ModuleProgress> modules;
+
+    dataobj_t to_json() const;
+  };
+  std::shared_ptr<const CommandProgress> get_progress() const { return std::atomic_load(&m_progress); }
+
 private:
   typedef std::map<std::string, std::shared_ptr<DAQModule>> DAQModuleMap_t; ///< DAQModules indexed by name
 
+  void initialize_modules(std::shared_ptr<ConfigurationManager> mgr, opmonlib::OpMonManager&);
   void init_modules(const std::vector<const dunedaq::confmodel::DaqModule*>& modules, opmonlib::OpMonManager & );
+  void validate_action_plans(ModuleConfiguration& mcfg);
+  // Stop the threads and timers of the modules, then drop them
+  void release_modules(DAQModuleMap_t& modules);
+  // Stops the module first and starts it again at the end if start_data is not null
+  bool reconfigure_module(const std::string& mod_name, const dataobj_t& conf_data, const dataobj_t* start_data);
+
+  /**
+   * @brief One AddressedCmd of a command, pointing into the command data object
+   *
+   * Modules receive a reference to the data object of the first AddressedCmd matching their name, so the command
+   * payload is never copied per module and each regex is compiled once per command.
+   */
+  struct AddressedData
+  {
+    std::string match;
+    std::regex match_re;
+    const dataobj_t* data;
+  };
+  using AddressedDataList_t = std::vector<AddressedData>;
 
-  void check_cmd_data(const std::string& id, const dataobj_t& cmd_data);
-  dataobj_t get_dataobj_for_module(const std::string& mod_name, const dataobj_t& cmd_data);
+  // Throws MalformedCommandData if cmd_data is neither null nor a CmdObj
+  AddressedDataList_t index_addressed_data(const std::string& cmd, const dataobj_t& cmd_data);
+  void check_cmd_data(const std::string& id, const AddressedDataList_t& addressed_data);
+  const dataobj_t& get_dataobj_for_module(const std::string& mod_name, const AddressedDataList_t& addressed_data);
   bool execute_action(const std::string& mod_name, const std::string& action, const dataobj_t& data_obj);
-  void execute_action_plan_step(const std::string& cmd, const confmodel::DaqModulesGroup* step, const dataobj_t& cmd_data, bool execution_mode_is_serial);
+  // Waits for a module action, cancelling the command if it passes its deadline
+  void wait_for_action(const std::string& cmd, std::future<bool>& action);
+  void execute_action_plan(const std::string& cmd,
+                           const confmodel::ActionPlan* action_plan,
+                           const AddressedDataList_t& addressed_data,
+                           CommandProgress& progress);
+  void execute_action_plan_step(const std::string& cmd,
+                                const confmodel::DaqModulesGroup* step,
+                                const AddressedDataList_t& addressed_data,
+                                bool execution_mode_is_serial);
 
   void check_mod_has_cmd(const std::string& cmd, const std::string& mod_class, const std::string& mod_id = "");
 
   std::vector<std::string> get_modnames_by_cmdid(cmdlib::cmd::CmdId id);
   std::shared_ptr<ModuleConfiguration> m_module_configuration;
+  // Configuration each module was last initialised with, keeping the configurations replaced by reconfigure() alive
+  // exactly as long as a module may still hold their DAL objects
+  std::map<std::string, std::shared_ptr<ModuleConfiguration>> m_module_configurations;
 
   bool m_initialized;
+  bool m_running{ false }; // between start and stop, for reconfigure
+  dataobj_t m_start_data;  // of the last start command
+  bool m_warm_restart;
+  bool m_iomanager_resident;
+  std::set<std::string> m_resident_connections;
 
   DAQModuleMap_t m_module_map;
   std::map<std::string, std::vector<std::string>> m_modules_by_type;
+
+  // Only accessed through std::atomic_load/std::atomic_store
+  std::shared_ptr<CommandProgress> m_progress;
+
+  TraceRecorder m_trace;
+
+  std::chrono::milliseconds m_command_timeout{ 0 };
+  bool m_fail_fast{ false };
+  std::chrono::steady_clock::time_point m_command_deadline;
+  // Cancellation of the command being executed, null between commands. Only accessed through
+  // std::atomic_load/std::atomic_store
+  std::shared_ptr<CancellationSource> m_cancellation;
 };
 
 } // namespace appfwk
@@ -0,0 +1,121 @@
+/**
+ * @file LatencyHistogram.cpp LatencyHistogram class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/LatencyHistogram.hpp"
+
+#include "appfwk/opmon/latency_histogram.pb.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace dunedaq::appfwk {
+
+uint64_t
+LatencyHistogram::bucket_upper(size_t index) noexcept
+{
+  if (index < sub_buckets)
+    return index;
+  size_t shift = (index >> sub_bucket_bits) - 1;
+  uint64_t lower = static_cast<uint64_t>((index & (sub_buckets - 1)) + sub_buckets) << shift;
+  return lower + ((uint64_t(1) << shift) - 1);
+}
+
+LatencyHistogram::Snapshot
+LatencyHistogram::snapshot() const
+{
+  Snapshot snapshot;
+  for (size_t i = 0; i < n_buckets; ++i) {
+    snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.counts[i];
+  }
+  snapshot.sum = m_sum.load(std::memory_order_relaxed);
+  snapshot.max = m_max.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+LatencyHistogram::Summary
+LatencyHistogram::summary_since(const Snapshot& earlier) const
+{
+  auto current = snapshot();
+  size_t highest = 0;
+  current.count = 0;
+  for (size_t i = 0; i < n_buckets; ++i) {
+    current.counts[i] -= earlier.counts[i];
+    current.count += current.counts[i];
+    if (current.counts[i] != 0)
+      highest = i;
+  }
+  current.sum -= earlier.sum;
+  current.max = std::min(current.max, bucket_upper(highest));
+  return summarise(current);
+}
+
+LatencyHistogram::Summary
+LatencyHistogram::interval_summary()
+{
+  std::lock_guard<std::mutex> lock(m_interval_mutex);
+  auto current = snapshot();
+  auto interval = current;
+  interval.count = 0;
+  for (size_t i = 0; i < n_buckets; ++i) {
+    interval.counts[i] -= m_interval_start.counts[i];
+    interval.count += interval.counts[i];
+  }
+  interval.sum -= m_interval_start.sum;
+  interval.max = m_interval_max.exchange(0, std::memory_order_relaxed);
+  m_interval_start = std::move(current);
+  return summarise(interval);
+}
+
+LatencyHistogram::Summary
+LatencyHistogram::summarise(const Snapshot& snapshot)
+{
+  Summary summary;
+  summary.count = snapshot.count;
+  summary.max = snapshot.max;
+  if (snapshot.count == 0)
+    return summary;
+  summary.mean = static_cast<double>(snapshot.sum) / snapshot.count;
+
+  // A single pass over the buckets, the fractions being in increasing order
+  const std::pair<double, uint64_t*> percentiles[] = {
+    { 0.5, &summary.p50 }, { 0.9, &summary.p90 }, { 0.99, &summary.p99 }, { 0.999, &summary.p999 }
+  };
+  size_t next = 0;
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < n_buckets && next < std::size(percentiles); ++i) {
+    cumulative += snapshot.counts[i];
+    while (next < std::size(percentiles) &&
+           cumulative >= std::max<uint64_t>(1, static_cast<uint64_t>(percentiles[next].first * snapshot.count + 0.5))) {
+      *percentiles[next].second = std::min(bucket_upper(i), snapshot.max);
+      ++next;
+    }
+  }
+  for (; next < std::size(percentiles); ++next)
+    *percentiles[next].second = snapshot.max;
+  return summary;
+}
+
+void
+OpMonLatencyHistogram::generate_opmon_data()
+{
+  auto summary = interval_summary();
+
+  opmon::LatencyHistogramInfo info;
+  info.set_count(summary.count);
+  info.set_mean_us(summary.mean / 1000.);
+  info.set_p50_us(summary.p50 / 1000.);
+  info.set_p90_us(summary.p90 / 1000.);
+  info.set_p99_us(summary.p99 / 1000.);
+  info.set_p999_us(summary.p999 / 1000.);
+  info.set_max_us(summary.max / 1000.);
+  publish(std::move(info));
+}
+
+} // namespace dunedaq::appfwk
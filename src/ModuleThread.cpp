@@ -0,0 +1,196 @@
+/**
+ * @file ModuleThread.cpp ModuleThread class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ModuleThread.hpp"
+
+#include "appfwk/opmon/module_thread.pb.h"
+#include "logging/Logging.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::appfwk {
+
+namespace {
+
+std::string
+format_cpus(const std::vector<int>& cpus)
+{
+  std::string result;
+  for (auto cpu : cpus)
+    result += (result.empty() ? "" : ",") + std::to_string(cpu);
+  return result;
+}
+
+uint64_t
+to_ns(const timeval& tv)
+{
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000000ULL + static_cast<uint64_t>(tv.tv_usec) * 1000ULL;
+}
+
+} // namespace
+
+ModuleThread::ModuleThread(const std::string& name, iteration_t iteration)
+  : utilities::NamedObject(name)
+  , m_iteration(std::move(iteration))
+{
+}
+
+ModuleThread::~ModuleThread() noexcept
+{
+  stop();
+}
+
+void
+ModuleThread::set_affinity(const std::vector<int>& cpus)
+{
+  const std::lock_guard<std::mutex> lock(m_affinity_mutex);
+  m_affinity = cpus;
+}
+
+std::vector<int>
+ModuleThread::get_affinity() const
+{
+  const std::lock_guard<std::mutex> lock(m_affinity_mutex);
+  return m_affinity;
+}
+
+void
+ModuleThread::set_iteration(iteration_t iteration)
+{
+  stop();
+  m_iteration = std::move(iteration);
+}
+
+void
+ModuleThread::start()
+{
+  if (m_thread.joinable()) {
+    if (running())
+      return;
+    // The iteration function ended the previous thread
+    m_thread.join();
+  }
+
+  m_base_user_ns = m_user_ns.load();
+  m_base_system_ns = m_system_ns.load();
+  m_base_voluntary_switches = m_voluntary_switches.load();
+  m_base_involuntary_switches = m_involuntary_switches.load();
+
+  m_run_requested.store(true);
+  m_looping.store(true, std::memory_order_release);
+  m_thread = std::thread(&ModuleThread::run, this);
+  TLOG_DEBUG(2) << "Started thread " << get_name();
+}
+
+void
+ModuleThread::stop()
+{
+  m_run_requested.store(false);
+  if (m_thread.joinable()) {
+    m_thread.join();
+    TLOG_DEBUG(2) << "Stopped thread " << get_name() << " after " << iterations() << " iterations";
+  }
+}
+
+void
+ModuleThread::run()
+{
+  const auto& name = get_name();
+  auto os_name = name.size() > 15 ? name.substr(name.size() - 15) : name;
+  pthread_setname_np(pthread_self(), os_name.c_str());
+
+  auto cpus = get_affinity();
+  if (!cpus.empty()) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    int rc = EINVAL;
+    for (auto cpu : cpus) {
+      if (cpu >= 0 && cpu < CPU_SETSIZE)
+        CPU_SET(cpu, &cpuset);
+    }
+    if (CPU_COUNT(&cpuset) > 0)
+      rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (rc != 0)
+      ers::warning(ThreadAffinityFailed(ERS_HERE, name, format_cpus(cpus), std::strerror(rc)));
+  }
+
+  auto next_sample = std::chrono::steady_clock::now();
+  try {
+    while (m_run_requested.load(std::memory_order_relaxed)) {
+      bool more = m_iteration();
+      // Single writer, no need for an atomic increment
+      m_iterations.store(m_iterations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      if (!more)
+        break;
+      auto now = std::chrono::steady_clock::now();
+      if (now >= next_sample) {
+        sample_usage();
+        next_sample = now + s_sample_period;
+      }
+    }
+  } catch (const ers::Issue& ex) {
+    ers::error(ModuleThreadFailed(ERS_HERE, name, ex.what(), ex));
+  } catch (const std::exception& ex) {
+    ers::error(ModuleThreadFailed(ERS_HERE, name, ex.what()));
+  }
+
+  sample_usage();
+  m_looping.store(false, std::memory_order_release);
+}
+
+void
+ModuleThread::sample_usage()
+{
+  rusage usage;
+  if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+    m_user_ns.store(m_base_user_ns + to_ns(usage.ru_utime), std::memory_order_relaxed);
+    m_system_ns.store(m_base_system_ns + to_ns(usage.ru_stime), std::memory_order_relaxed);
+    m_voluntary_switches.store(m_base_voluntary_switches + usage.ru_nvcsw, std::memory_order_relaxed);
+    m_involuntary_switches.store(m_base_involuntary_switches + usage.ru_nivcsw, std::memory_order_relaxed);
+  }
+  m_cpu.store(sched_getcpu(), std::memory_order_relaxed);
+}
+
+void
+ModuleThread::generate_opmon_data()
+{
+  auto now = std::chrono::steady_clock::now();
+  double elapsed_s = std::chrono::duration<double>(now - m_report_time).count();
+  auto iterations = m_iterations.load(std::memory_order_relaxed);
+  auto user_ns = m_user_ns.load(std::memory_order_relaxed);
+  auto system_ns = m_system_ns.load(std::memory_order_relaxed);
+
+  opmon::ModuleThreadInfo info;
+  info.set_running(running());
+  info.set_cpu(m_cpu.load(std::memory_order_relaxed));
+  info.set_affinity(format_cpus(get_affinity()));
+  info.set_iterations(iterations);
+  info.set_user_time_s(user_ns / 1e9);
+  info.set_system_time_s(system_ns / 1e9);
+  info.set_voluntary_ctx_switches(m_voluntary_switches.load(std::memory_order_relaxed));
+  info.set_involuntary_ctx_switches(m_involuntary_switches.load(std::memory_order_relaxed));
+  if (elapsed_s > 0) {
+    info.set_iterations_per_s((iterations - m_reported_iterations) / elapsed_s);
+    info.set_cpu_utilisation((user_ns + system_ns - m_reported_cpu_ns) / 1e9 / elapsed_s);
+  }
+  m_reported_iterations = iterations;
+  m_reported_cpu_ns = user_ns + system_ns;
+  m_report_time = now;
+
+  publish(std::move(info));
+}
+
+} // namespace dunedaq::appfwk
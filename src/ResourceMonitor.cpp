@@ -0,0 +1,129 @@
+/**
+ * @file ResourceMonitor.cpp ResourceMonitor class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "ResourceMonitor.hpp"
+
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace dunedaq {
+namespace appfwk {
+
+namespace {
+
+std::string
+read_hostname()
+{
+  char hostname[256];
+  if (gethostname(hostname, sizeof(hostname)) < 0)
+    return "Unknown";
+  hostname[sizeof(hostname) - 1] = '\0';
+  return hostname;
+}
+
+double
+to_s(const timeval& tv)
+{
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Thread count, virtual size in bytes and resident size in pages, from /proc/self/stat
+void
+read_stat(ResourceMonitor::Usage& usage, uint64_t page_size)
+{
+  std::ifstream stat("/proc/self/stat");
+  std::string line;
+  if (!std::getline(stat, line))
+    return;
+
+  // The command name, field 2, is in parentheses and may contain spaces: count the fields after its closing one
+  auto name_end = line.rfind(')');
+  if (name_end == std::string::npos)
+    return;
+  std::istringstream fields(line.substr(name_end + 1));
+  std::string field;
+  uint64_t rss_pages = 0;
+  for (int index = 3; fields >> field; ++index) {
+    if (index == 20)
+      usage.threads = std::stoul(field);
+    else if (index == 23)
+      usage.vsize_bytes = std::stoull(field);
+    else if (index == 24) {
+      rss_pages = std::stoull(field);
+      break;
+    }
+  }
+  usage.rss_bytes = rss_pages * page_size;
+}
+
+uint32_t
+count_open_fds()
+{
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr)
+    return 0;
+  uint32_t count = 0;
+  while (auto* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.')
+      ++count;
+  }
+  closedir(dir);
+  return count > 0 ? count - 1 : 0; // not counting the descriptor of dir itself
+}
+
+} // namespace
+
+ResourceMonitor::ResourceMonitor()
+  : m_hostname(read_hostname())
+  , m_page_size(static_cast<uint64_t>(sysconf(_SC_PAGESIZE)))
+  , m_last_time(std::chrono::steady_clock::now())
+{
+  Usage initial;
+  read_stat(initial, m_page_size);
+  m_last_rss_bytes = initial.rss_bytes;
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    m_last_cpu_time_s = to_s(usage.ru_utime) + to_s(usage.ru_stime);
+}
+
+ResourceMonitor::Usage
+ResourceMonitor::sample()
+{
+  Usage result;
+  read_stat(result, m_page_size);
+  result.open_fds = count_open_fds();
+
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    result.user_time_s = to_s(usage.ru_utime);
+    result.system_time_s = to_s(usage.ru_stime);
+    result.voluntary_ctx_switches = usage.ru_nvcsw;
+    result.involuntary_ctx_switches = usage.ru_nivcsw;
+    result.minor_faults = usage.ru_minflt;
+    result.major_faults = usage.ru_majflt;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto now = std::chrono::steady_clock::now();
+  double elapsed_s = std::chrono::duration<double>(now - m_last_time).count();
+  double cpu_time_s = result.user_time_s + result.system_time_s;
+  if (elapsed_s > 0)
+    result.cpu_utilisation = (cpu_time_s - m_last_cpu_time_s) / elapsed_s;
+  result.rss_growth_bytes = static_cast<int64_t>(result.rss_bytes) - static_cast<int64_t>(m_last_rss_bytes);
+  m_last_rss_bytes = result.rss_bytes;
+  m_last_cpu_time_s = cpu_time_s;
+  m_last_time = now;
+  return result;
+}
+
+} // namespace appfwk
+} // namespace dunedaq
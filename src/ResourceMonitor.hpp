@@ -0,0 +1,70 @@
+/**
+ * @file ResourceMonitor.hpp Resource usage of the application process, for its opmon data
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_RESOURCEMONITOR_HPP_
+#define APPFWK_INCLUDE_APPFWK_RESOURCEMONITOR_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace appfwk {
+
+/**
+ * @brief Samples the memory, CPU, scheduling, page fault, thread and file descriptor usage of the process
+ *
+ * Data which cannot change while the process runs (host name, page size) is read once at construction. Every call
+ * to sample() reads /proc/self/stat, /proc/self/fd and getrusage, and also returns the changes since the previous
+ * call, so that memory growth and CPU saturation show up per opmon interval. Reading a counter which is not
+ * available leaves it at 0.
+ */
+class ResourceMonitor
+{
+public:
+  struct Usage
+  {
+    uint64_t rss_bytes{ 0 };
+    uint64_t vsize_bytes{ 0 };
+    int64_t rss_growth_bytes{ 0 }; ///< Since the previous sample
+    double user_time_s{ 0 };
+    double system_time_s{ 0 };
+    double cpu_utilisation{ 0 }; ///< Average number of cores used since the previous sample
+    uint64_t voluntary_ctx_switches{ 0 };
+    uint64_t involuntary_ctx_switches{ 0 };
+    uint64_t minor_faults{ 0 };
+    uint64_t major_faults{ 0 };
+    uint32_t threads{ 0 };
+    uint32_t open_fds{ 0 };
+  };
+
+  ResourceMonitor();
+
+  ResourceMonitor(const ResourceMonitor&) = delete;
+  ResourceMonitor& operator=(const ResourceMonitor&) = delete;
+
+  const std::string& hostname() const { return m_hostname; }
+
+  Usage sample();
+
+private:
+  const std::string m_hostname;
+  const uint64_t m_page_size;
+
+  // Previous sample, for the increments
+  std::mutex m_mutex;
+  uint64_t m_last_rss_bytes{ 0 };
+  double m_last_cpu_time_s{ 0 };
+  std::chrono::steady_clock::time_point m_last_time;
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_INCLUDE_APPFWK_RESOURCEMONITOR_HPP_
@@ -0,0 +1,139 @@
+/**
+ * @file ShardedCounter.cpp ShardedCounter and OpMonCounters implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ShardedCounter.hpp"
+
+#include "appfwk/opmon/sharded_counter.pb.h"
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+namespace dunedaq::appfwk {
+
+namespace detail {
+
+namespace {
+
+// Indices of the threads alive: a new thread gets the lowest free one, so that threads alive at the same time only
+// share a cell if there are more of them than cells
+class ShardIndices
+{
+public:
+  size_t acquire()
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.empty())
+      return m_next++;
+    auto index = *m_free.begin();
+    m_free.erase(m_free.begin());
+    return index;
+  }
+
+  void release(size_t index)
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.insert(index);
+  }
+
+private:
+  std::mutex m_mutex;
+  std::set<size_t> m_free;
+  size_t m_next = 0;
+};
+
+ShardIndices&
+shard_indices()
+{
+  static ShardIndices s_indices;
+  return s_indices;
+}
+
+// Holds the index of a thread until it exits
+struct ThreadShardIndex
+{
+  ThreadShardIndex()
+    : index(shard_indices().acquire())
+  {
+  }
+  ~ThreadShardIndex() { shard_indices().release(index); }
+
+  const size_t index;
+};
+
+} // namespace
+
+size_t
+thread_shard_index() noexcept
+{
+  thread_local const ThreadShardIndex index;
+  return index.index;
+}
+
+size_t
+default_shards() noexcept
+{
+  static const size_t shards = []() {
+    size_t cores = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 64);
+    size_t shards = 1;
+    while (shards < cores)
+      shards <<= 1;
+    return shards;
+  }();
+  return shards;
+}
+
+} // namespace detail
+
+ShardedCounter&
+OpMonCounters::counter(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& entry = m_counters[name];
+  if (!entry)
+    entry = std::make_unique<Counter>();
+  return entry->counter;
+}
+
+ShardedGauge&
+OpMonCounters::gauge(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& entry = m_gauges[name];
+  if (!entry)
+    entry = std::make_unique<ShardedGauge>();
+  return *entry;
+}
+
+void
+OpMonCounters::generate_opmon_data()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto now = std::chrono::steady_clock::now();
+  double elapsed_s = std::chrono::duration<double>(now - m_report_time).count();
+  m_report_time = now;
+
+  for (auto& [name, entry] : m_counters) {
+    auto value = entry->counter.value();
+    opmon::CounterInfo info;
+    info.set_value(value);
+    if (elapsed_s > 0)
+      info.set_rate_per_s((value - entry->reported) / elapsed_s);
+    entry->reported = value;
+    publish(std::move(info), { { "metric", name } });
+  }
+  for (auto& [name, gauge] : m_gauges) {
+    opmon::GaugeInfo info;
+    info.set_value(gauge->value());
+    publish(std::move(info), { { "metric", name } });
+  }
+}
+
+} // namespace dunedaq::appfwk
@@ -0,0 +1,352 @@
+/**
+ * @file TimerService.cpp TimerService class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/TimerService.hpp"
+
+#include "appfwk/opmon/timer_service.pb.h"
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::appfwk {
+
+namespace {
+
+// Timer whose callback runs on the current thread, so that it can cancel itself without waiting for itself
+thread_local TimerService::timer_id_t t_current_timer = 0;
+
+void
+update_max(std::atomic<uint64_t>& max, uint64_t value)
+{
+  auto current = max.load(std::memory_order_relaxed);
+  while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t
+to_ticks(std::chrono::milliseconds duration)
+{
+  auto ticks = (duration + TimerService::tick - std::chrono::milliseconds(1)) / TimerService::tick;
+  return static_cast<uint64_t>(std::max<int64_t>(ticks, 0));
+}
+
+} // namespace
+
+TimerService::TimerService(size_t n_workers)
+  : m_origin(clock_t::now())
+{
+  m_wheel_thread = std::thread(&TimerService::run_wheel, this);
+  for (size_t i = 0; i < std::max<size_t>(n_workers, 1); ++i)
+    m_workers.emplace_back(&TimerService::run_worker, this);
+}
+
+TimerService::~TimerService() noexcept
+{
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wheel_cv.notify_all();
+  m_work_cv.notify_all();
+  m_wheel_thread.join();
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+TimerService::timer_id_t
+TimerService::schedule_once(const std::string& name, std::chrono::milliseconds delay, callback_t callback)
+{
+  return add(name, to_ticks(delay), 0, std::move(callback));
+}
+
+TimerService::timer_id_t
+TimerService::schedule_periodic(const std::string& name,
+                                std::chrono::milliseconds period,
+                                callback_t callback,
+                                std::chrono::milliseconds first_delay)
+{
+  return add(name, to_ticks(first_delay), std::max<uint64_t>(to_ticks(period), 1), std::move(callback));
+}
+
+TimerService::timer_id_t
+TimerService::add(const std::string& name, uint64_t delay_ticks, uint64_t period_ticks, callback_t callback)
+{
+  auto timer = std::make_shared<Timer>();
+  timer->name = name;
+  timer->callback = std::move(callback);
+  timer->period_ticks = std::min(period_ticks, s_max_delay_ticks);
+
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    timer->id = m_next_id++;
+    auto now_tick = elapsed_ticks(clock_t::now());
+    // Without timers the wheel does not follow the clock, nothing is lost by moving it to the present
+    if (m_timers.empty())
+      m_now_tick = std::max(m_now_tick, now_tick);
+    // The delay counts from now, which may be a few ticks ahead of the wheel. The expiry is rounded up to the next
+    // tick boundary, so that the callback never runs early.
+    auto lag = std::min(now_tick > m_now_tick ? now_tick - m_now_tick : 0, s_max_delay_ticks - 1);
+    timer->expiry_tick = m_now_tick + lag + 1 + std::min(delay_ticks, s_max_delay_ticks - lag - 1);
+    m_timers.emplace(timer->id, timer);
+    insert(timer);
+    m_wheel_changed = true;
+  }
+  m_wheel_cv.notify_one();
+  return timer->id;
+}
+
+bool
+TimerService::cancel(timer_id_t id)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto it = m_timers.find(id);
+  if (it == m_timers.end())
+    return false;
+
+  // The wheel and the ready queue drop cancelled timers when they reach them
+  auto timer = it->second;
+  timer->cancelled = true;
+  m_timers.erase(it);
+  if (t_current_timer != id)
+    m_done_cv.wait(lock, [&]() { return !timer->running; });
+  return true;
+}
+
+bool
+TimerService::scheduled(timer_id_t id) const
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_timers.count(id) != 0;
+}
+
+size_t
+TimerService::size() const
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_timers.size();
+}
+
+std::vector<TimerService::TimerStats>
+TimerService::get_stats() const
+{
+  std::vector<TimerStats> stats;
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  for (const auto& [id, timer] : m_timers) {
+    auto runs = timer->runs.load(std::memory_order_relaxed);
+    stats.push_back(TimerStats{ timer->name,
+                                runs,
+                                timer->overruns.load(std::memory_order_relaxed),
+                                runs == 0 ? 0. : timer->total_lateness_ns.load(std::memory_order_relaxed) / 1e3 / runs,
+                                timer->max_lateness_ns.load(std::memory_order_relaxed) / 1e3,
+                                timer->max_duration_ns.load(std::memory_order_relaxed) / 1e3 });
+  }
+  return stats;
+}
+
+// Must be called with m_mutex held. The timer goes to the lowest level whose slots, counted from m_now_tick, reach
+// its expiry: level 0 holds the timers due in the current 256 ticks, level 1 those due in the current 65536 ticks...
+void
+TimerService::insert(const TimerPtr& timer)
+{
+  auto delta = timer->expiry_tick - m_now_tick;
+  size_t level = 0;
+  while (level + 1 < s_levels && delta >= (uint64_t(1) << (s_slot_bits * (level + 1))))
+    ++level;
+  auto slot = (timer->expiry_tick >> (s_slot_bits * level)) & s_slot_mask;
+  m_wheel[level][slot].push_back(timer);
+  if (level == 0)
+    m_level0_occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+}
+
+// Must be called with m_mutex held, for every tick in turn
+void
+TimerService::advance(uint64_t tick)
+{
+  m_now_tick = tick;
+
+  // At every turn of a level, the next slot of the level above is spread over the lower levels
+  for (size_t level = 1; level < s_levels; ++level) {
+    if (((tick >> (s_slot_bits * (level - 1))) & s_slot_mask) != 0)
+      break;
+    auto& slot = m_wheel[level][(tick >> (s_slot_bits * level)) & s_slot_mask];
+    auto timers = std::move(slot);
+    slot.clear();
+    for (auto& timer : timers) {
+      if (!timer->cancelled)
+        insert(timer);
+    }
+  }
+
+  auto index = tick & s_slot_mask;
+  if ((m_level0_occupied[index / 64] & (uint64_t(1) << (index % 64))) == 0)
+    return;
+  m_level0_occupied[index / 64] &= ~(uint64_t(1) << (index % 64));
+  auto timers = std::move(m_wheel[0][index]);
+  m_wheel[0][index].clear();
+
+  for (auto& timer : timers) {
+    if (timer->cancelled)
+      continue;
+    if (timer->queued || timer->running) {
+      timer->overruns.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      timer->queued = true;
+      m_ready.emplace_back(timer, tick);
+    }
+    if (timer->period_ticks != 0) {
+      timer->expiry_tick += timer->period_ticks;
+      insert(timer);
+    }
+  }
+}
+
+// Must be called with m_mutex held: the next tick with level 0 timers, or at which the wheel has to cascade
+uint64_t
+TimerService::next_wake_tick() const
+{
+  auto index = (m_now_tick & s_slot_mask) + 1;
+  while (index < s_slots) {
+    auto word = m_level0_occupied[index / 64] >> (index % 64);
+    if (word != 0)
+      return m_now_tick - (m_now_tick & s_slot_mask) + index + __builtin_ctzll(word);
+    index = (index / 64 + 1) * 64;
+  }
+  return (m_now_tick | s_slot_mask) + 1;
+}
+
+uint64_t
+TimerService::elapsed_ticks(clock_t::time_point time) const
+{
+  return static_cast<uint64_t>((time - m_origin) / tick);
+}
+
+void
+TimerService::run_wheel()
+{
+  pthread_setname_np(pthread_self(), "timer-wheel");
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stopping) {
+    auto target = elapsed_ticks(clock_t::now());
+    if (m_timers.empty()) {
+      // Only cancelled timers can be left in the wheel, no need to go through the ticks
+      m_now_tick = std::max(m_now_tick, target);
+    }
+    auto ready_before = m_ready.size();
+    while (m_now_tick < target)
+      advance(m_now_tick + 1);
+    auto n_ready = m_ready.size() - ready_before;
+    if (n_ready == 1)
+      m_work_cv.notify_one();
+    else if (n_ready > 1)
+      m_work_cv.notify_all();
+
+    m_wheel_changed = false;
+    auto predicate = [&]() { return m_stopping || m_wheel_changed; };
+    if (m_timers.empty())
+      m_wheel_cv.wait(lock, predicate);
+    else
+      m_wheel_cv.wait_until(lock, tick_time(next_wake_tick()), predicate);
+  }
+}
+
+void
+TimerService::run_worker()
+{
+  pthread_setname_np(pthread_self(), "timer-worker");
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_work_cv.wait(lock, [&]() { return m_stopping || !m_ready.empty(); });
+    if (m_stopping)
+      return;
+
+    auto [timer, due_tick] = std::move(m_ready.front());
+    m_ready.pop_front();
+    timer->queued = false;
+    if (timer->cancelled)
+      continue;
+    timer->running = true;
+    lock.unlock();
+
+    auto start = clock_t::now();
+    auto lateness_ns = static_cast<uint64_t>(
+      std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(start - tick_time(due_tick)).count()));
+    t_current_timer = timer->id;
+    try {
+      timer->callback();
+    } catch (const ers::Issue& ex) {
+      ers::error(TimerCallbackFailed(ERS_HERE, timer->name, ex.what(), ex));
+    } catch (const std::exception& ex) {
+      ers::error(TimerCallbackFailed(ERS_HERE, timer->name, ex.what()));
+    }
+    t_current_timer = 0;
+    auto duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - start).count();
+
+    timer->runs.fetch_add(1, std::memory_order_relaxed);
+    timer->total_lateness_ns.fetch_add(lateness_ns, std::memory_order_relaxed);
+    update_max(timer->max_lateness_ns, lateness_ns);
+    update_max(timer->interval_max_lateness_ns, lateness_ns);
+    update_max(timer->max_duration_ns, static_cast<uint64_t>(duration_ns));
+
+    lock.lock();
+    timer->running = false;
+    if (timer->period_ticks == 0)
+      m_timers.erase(timer->id);
+    m_done_cv.notify_all();
+  }
+}
+
+void
+TimerService::generate_opmon_data()
+{
+  std::vector<TimerPtr> timers;
+  size_t ready = 0;
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [id, timer] : m_timers)
+      timers.push_back(timer);
+    ready = m_ready.size();
+  }
+
+  opmon::TimerServiceInfo info;
+  info.set_timers(timers.size());
+  info.set_ready(ready);
+  for (const auto& timer : timers) {
+    auto runs = timer->runs.load(std::memory_order_relaxed);
+    auto interval_max_ns = timer->interval_max_lateness_ns.exchange(0, std::memory_order_relaxed);
+    info.set_max_lateness_us(std::max(info.max_lateness_us(), interval_max_ns / 1e3));
+
+    opmon::TimerInfo ti;
+    ti.set_runs(runs);
+    ti.set_overruns(timer->overruns.load(std::memory_order_relaxed));
+    ti.set_period_ms(timer->period_ticks * tick.count());
+    if (runs > 0)
+      ti.set_mean_lateness_us(timer->total_lateness_ns.load(std::memory_order_relaxed) / 1e3 / runs);
+    ti.set_max_lateness_us(interval_max_ns / 1e3);
+    ti.set_max_duration_us(timer->max_duration_ns.load(std::memory_order_relaxed) / 1e3);
+    publish(std::move(ti), { { "timer", timer->name } });
+  }
+  publish(std::move(info));
+}
+
+std::shared_ptr<TimerService>
+get_timer_service()
+{
+  static auto service = std::make_shared<TimerService>();
+  return service;
+}
+
+} // namespace dunedaq::appfwk
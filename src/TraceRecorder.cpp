@@ -0,0 +1,183 @@
+/**
+ * @file TraceRecorder.cpp TraceRecorder implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TraceRecorder.hpp"
+
+#include "appfwk/Issues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <chrono>
+#include <exception>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+namespace dunedaq {
+namespace appfwk {
+
+namespace {
+
+int64_t
+current_tid()
+{
+  thread_local const int64_t tid = syscall(SYS_gettid);
+  return tid;
+}
+
+std::atomic<uint64_t> s_last_generation{ 0 };
+
+} // namespace
+
+TraceRecorder::Scope::Scope(TraceRecorder& recorder, std::string name, std::string category, dataobj_t args)
+  : m_recorder(recorder)
+  , m_name(std::move(name))
+  , m_category(std::move(category))
+  , m_args(std::move(args))
+  , m_generation(recorder.enabled() ? recorder.m_generation.load(std::memory_order_acquire) : 0)
+  , m_start_ticks(m_generation != 0 ? TscClock::now() : 0)
+  , m_uncaught_exceptions(std::uncaught_exceptions())
+{
+}
+
+TraceRecorder::Scope::~Scope()
+{
+  if (m_generation == 0 || !m_recorder.enabled() ||
+      m_generation != m_recorder.m_generation.load(std::memory_order_acquire))
+    return;
+  try {
+    if (std::uncaught_exceptions() > m_uncaught_exceptions)
+      m_args["failed"] = true;
+    auto end_ticks = TscClock::now();
+    m_recorder.record(m_name,
+                      m_category,
+                      TscClock::to_steady_ns(m_start_ticks),
+                      TscClock::to_steady_ns(end_ticks),
+                      std::move(m_args));
+  } catch (...) { // NOLINT: a trace must never turn into an error
+  }
+}
+
+int64_t
+TraceRecorder::now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+void
+TraceRecorder::open(const std::string& path, const std::string& process_name)
+{
+  close();
+  if (path.empty())
+    return;
+
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_file.open(path, std::ios::out | std::ios::trunc);
+  if (!m_file.is_open()) {
+    throw BadFile(ERS_HERE, path);
+  }
+  m_file << "[";
+  m_first_event = true;
+  if (!process_name.empty()) {
+    write_locked(
+      { { "name", "process_name" }, { "ph", "M" }, { "pid", getpid() }, { "args", { { "name", process_name } } } });
+  }
+  m_file.flush();
+  m_generation.store(++s_last_generation, std::memory_order_release);
+  m_enabled.store(true, std::memory_order_release);
+  TLOG() << "Writing the command execution trace to " << path;
+}
+
+void
+TraceRecorder::close()
+{
+  m_enabled.store(false, std::memory_order_release);
+  flush();
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_file.is_open()) {
+    m_file << "\n]\n";
+    m_file.close();
+  }
+}
+
+void
+TraceRecorder::record(const std::string& name,
+                      const std::string& category,
+                      int64_t start_ns,
+                      int64_t end_ns,
+                      dataobj_t args)
+{
+  if (!enabled())
+    return;
+
+  // Chrome trace-event times are in microseconds
+  dataobj_t event{ { "name", name },
+                   { "cat", category },
+                   { "ph", "X" },
+                   { "ts", start_ns / 1000. },
+                   { "dur", (end_ns - start_ns) / 1000. },
+                   { "pid", getpid() },
+                   { "tid", current_tid() },
+                   { "args", std::move(args) } };
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.push_back(std::move(event));
+}
+
+void
+TraceRecorder::name_thread(const std::string& name)
+{
+  if (!enabled())
+    return;
+
+  // Module actions run on threads of their own, so the same label would otherwise be repeated on every action
+  struct NamedTrack
+  {
+    uint64_t generation{ 0 };
+    std::string name;
+  };
+  thread_local NamedTrack named;
+  auto generation = m_generation.load(std::memory_order_acquire);
+  if (named.generation == generation && named.name == name)
+    return;
+  named.generation = generation;
+  named.name = name;
+
+  dataobj_t event{ { "name", "thread_name" },
+                   { "ph", "M" },
+                   { "pid", getpid() },
+                   { "tid", current_tid() },
+                   { "args", { { "name", name } } } };
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.push_back(std::move(event));
+}
+
+void
+TraceRecorder::flush()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_file.is_open()) {
+    m_events.clear();
+    return;
+  }
+  for (const auto& event : m_events)
+    write_locked(event);
+  m_events.clear();
+  m_file.flush();
+}
+
+void
+TraceRecorder::write_locked(const dataobj_t& event)
+{
+  m_file << (m_first_event ? "\n" : ",\n") << event.dump();
+  m_first_event = false;
+}
+
+} // namespace appfwk
+} // namespace dunedaq
@@ -0,0 +1,101 @@
+/**
+ * @file TraceRecorder.hpp Timeline of command execution in Chrome trace-event format
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_INCLUDE_APPFWK_TRACERECORDER_HPP_
+#define APPFWK_INCLUDE_APPFWK_TRACERECORDER_HPP_
+
+#include "appfwk/TscClock.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+/**
+ * @brief Records timed events and writes them as a Chrome trace-event JSON array
+ *
+ * Every event is a "complete" event with the begin time, the duration and the id of the thread it was recorded
+ * on, so the file can be opened in Perfetto or chrome://tracing. Events are buffered in memory and appended to the
+ * file by flush(); the closing bracket is written by close(), a file left without it is still accepted by both
+ * viewers. Recording is a no-op, apart from an atomic load, while no file is open.
+ */
+class TraceRecorder
+{
+public:
+  using dataobj_t = nlohmann::json;
+
+  /**
+   * @brief Times a scope and records it when the scope exits
+   *
+   * An exception propagating out of the scope is marked with "failed": true in the event arguments. A scope is
+   * only recorded into the trace file that was open when it began, so one begun while tracing was off is dropped.
+   */
+  class Scope
+  {
+  public:
+    Scope(TraceRecorder& recorder, std::string name, std::string category, dataobj_t args = dataobj_t::object());
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    TraceRecorder& m_recorder;
+    std::string m_name;
+    std::string m_category;
+    dataobj_t m_args;
+    uint64_t m_generation;
+    TscClock::ticks_t m_start_ticks;
+    int m_uncaught_exceptions;
+  };
+
+  TraceRecorder() = default;
+  ~TraceRecorder() { close(); }
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  /// Starts a new trace file, throws BadFile if it cannot be written. An empty path stops tracing.
+  void open(const std::string& path, const std::string& process_name = "");
+  void close();
+  bool enabled() const { return m_enabled.load(std::memory_order_acquire); }
+
+  /// Records an event of the calling thread, times are steady_clock nanoseconds from now_ns()
+  void record(const std::string& name,
+              const std::string& category,
+              int64_t start_ns,
+              int64_t end_ns,
+              dataobj_t args = dataobj_t::object());
+  /// Labels the track of the calling thread, once per thread and trace file
+  void name_thread(const std::string& name);
+  /// Writes the buffered events to the file
+  void flush();
+
+  static int64_t now_ns();
+
+private:
+  void write_locked(const dataobj_t& event);
+
+  std::atomic<bool> m_enabled{ false };
+  /// Identifies the open trace file, unique across recorders; 0 while none was opened
+  std::atomic<uint64_t> m_generation{ 0 };
+  std::mutex m_mutex;
+  std::ofstream m_file;
+  bool m_first_event{ true };
+  std::vector<dataobj_t> m_events;
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_INCLUDE_APPFWK_TRACERECORDER_HPP_
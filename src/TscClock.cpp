@@ -0,0 +1,181 @@
+/**
+ * @file TscClock.cpp TscClock class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/TscClock.hpp"
+
+#include "appfwk/OpMonSnapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace dunedaq::appfwk {
+
+namespace {
+
+constexpr auto initial_calibration = std::chrono::milliseconds(10);
+constexpr int64_t min_refinement_ns = 1000000000LL;        // 1 s
+constexpr int64_t max_refinement_ns = 3600 * 1000000000LL; // 1 h
+
+struct Sample
+{
+  TscClock::ticks_t ticks;
+  int64_t ns;
+};
+
+// Tick rate and a reference point, to convert timestamps close to it
+struct Calibration
+{
+  TscClock::ticks_t base_ticks;
+  int64_t base_ns;
+  double ns_per_tick;
+};
+
+int64_t
+steady_clock_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+// TSC read paired with the middle of the narrowest of a few steady_clock brackets, to leave out preemptions
+Sample
+sample()
+{
+  Sample best{ 0, 0 };
+  int64_t best_width = std::numeric_limits<int64_t>::max();
+  for (int i = 0; i < 5; ++i) {
+    auto before = steady_clock_ns();
+    auto ticks = TscClock::now();
+    auto after = steady_clock_ns();
+    if (after - before < best_width) {
+      best_width = after - before;
+      best = { ticks, before + best_width / 2 };
+    }
+  }
+  return best;
+}
+
+/**
+ * The first rate is measured over a short sleep. Every refinement measures it again from the same origin, so that
+ * its error decreases with the time since the origin, and moves the reference point to the new sample. Refinements
+ * happen when a timestamp is converted to steady_clock time at least as long after the reference point as the
+ * reference point is after the origin (between 1 s and 1 h).
+ */
+class Calibrator
+{
+public:
+  Calibrator()
+    : m_origin(sample())
+  {
+    std::this_thread::sleep_for(initial_calibration);
+    update(sample());
+  }
+
+  Calibration get() const noexcept { return m_calibration.load(); }
+  double ns_per_tick() const noexcept { return m_ns_per_tick.load(std::memory_order_relaxed); }
+
+  void refine_if_due(const Calibration& current, TscClock::ticks_t timestamp) noexcept
+  {
+    if (timestamp <= current.base_ticks)
+      return;
+    auto interval = std::clamp(current.base_ns - m_origin.ns, min_refinement_ns, max_refinement_ns);
+    if ((timestamp - current.base_ticks) * current.ns_per_tick < interval)
+      return;
+
+    // Refinements are rare and optional, a conversion never waits for another one
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_calibration.writer_view().base_ticks != current.base_ticks)
+      return;
+    update(sample());
+  }
+
+private:
+  void update(const Sample& now) noexcept
+  {
+    Calibration calibration{
+      now.ticks, now.ns, static_cast<double>(now.ns - m_origin.ns) / (now.ticks - m_origin.ticks)
+    };
+    m_calibration.store(calibration);
+    m_ns_per_tick.store(calibration.ns_per_tick, std::memory_order_relaxed);
+  }
+
+  const Sample m_origin;
+  std::mutex m_mutex; // held by the thread refining the calibration, the single writer of m_calibration
+  OpMonSnapshot<Calibration> m_calibration;
+  std::atomic<double> m_ns_per_tick{ 0 }; // alone, for the conversion of durations which do not need the base
+};
+
+Calibrator&
+calibrator()
+{
+  static Calibrator s_calibrator;
+  return s_calibrator;
+}
+
+} // namespace
+
+bool
+TscClock::detect_invariant_tsc() noexcept
+{
+  if (std::getenv("APPFWK_DISABLE_TSC") != nullptr)
+    return false;
+#if defined(__x86_64__) || defined(__i386__)
+  // CPUID leaf 0x80000007, EDX bit 8: the TSC runs at a constant rate in all ACPI P-, C- and T-states
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+    return false;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+    return false;
+  return (edx & (1u << 8)) != 0;
+#else
+  return false;
+#endif
+}
+
+void
+TscClock::calibrate() noexcept
+{
+  if (uses_tsc())
+    calibrator();
+}
+
+uint64_t
+TscClock::to_ns(ticks_t ticks) noexcept
+{
+  if (!uses_tsc())
+    return ticks;
+  return static_cast<uint64_t>(ticks * calibrator().ns_per_tick() + 0.5);
+}
+
+int64_t
+TscClock::to_steady_ns(ticks_t timestamp) noexcept
+{
+  if (!uses_tsc())
+    return static_cast<int64_t>(timestamp);
+  auto& cal = calibrator();
+  auto current = cal.get();
+  cal.refine_if_due(current, timestamp);
+  auto delta = static_cast<int64_t>(timestamp - current.base_ticks); // negative for timestamps before the base
+  return current.base_ns + static_cast<int64_t>(delta * current.ns_per_tick);
+}
+
+double
+TscClock::ticks_per_ns() noexcept
+{
+  return uses_tsc() ? 1. / calibrator().ns_per_tick() : 1.;
+}
+
+} // namespace dunedaq::appfwk
@@ -0,0 +1,229 @@
+/**
+ * @file fsm_soak_test.cxx
+ *
+ * Repeats init/conf/start/stop/scrap cycles many times in one process and checks that the resident memory, the
+ * number of threads, the number of open file descriptors and the transition latencies do not keep growing.
+ *
+ * The first phase builds a new DAQModuleManager at every cycle and runs the full init/conf/start/stop/scrap
+ * sequence, the second one drives the conf/start/stop/scrap transitions through a single Application.
+ * The test fails if, after a warm-up, the lowest value of a quantity over the last quarter of the cycles is above
+ * its highest value over the first quarter (by more than a tolerance for memory and latencies).
+ *
+ * Usage: fsm_soak_test [cycles] [oks config] [application] [session] [stdin command file]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "Application.hpp"
+#include "DAQModuleManager.hpp"
+
+#include "appfwk/cmd/Nljs.hpp"
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp" // NOLINT
+#include "opmonlib/TestOpMonManager.hpp"
+#include "rcif/cmd/Nljs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+// Growth allowed between the first and the last quarter of the cycles
+constexpr double rss_tolerance_kb = 1024;
+constexpr double latency_tolerance_factor = 2.;
+constexpr double latency_tolerance_ms = 1.;
+
+struct Sample
+{
+  double rss_kb;
+  double threads;
+  double fds;
+  std::map<std::string, double> latencies_ms;
+};
+
+size_t
+count_entries(const std::string& dir)
+{
+  size_t n = 0;
+  for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator(dir))
+    ++n;
+  return n;
+}
+
+Sample
+sample_process()
+{
+  Sample sample;
+  std::ifstream statm("/proc/self/statm");
+  size_t size_pages = 0, resident_pages = 0;
+  statm >> size_pages >> resident_pages;
+  sample.rss_kb = resident_pages * (sysconf(_SC_PAGESIZE) / 1024.);
+  sample.threads = count_entries("/proc/self/task");
+  sample.fds = count_entries("/proc/self/fd");
+  return sample;
+}
+
+template<typename F>
+void
+timed(Sample& sample, const std::string& step, F&& f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  sample.latencies_ms[step] = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Returns false if the quantity is persistently higher at the end of the test than at its beginning
+bool
+check_growth(const std::string& phase,
+             const std::string& name,
+             const std::vector<double>& values,
+             double tolerance_factor,
+             double tolerance)
+{
+  auto warmup = std::max<size_t>(1, values.size() / 10);
+  if (values.size() < warmup + 4) {
+    TLOG() << phase << " " << name << ": not enough cycles to check growth";
+    return true;
+  }
+  auto quarter = (values.size() - warmup) / 4;
+  auto first_begin = values.begin() + warmup;
+  auto last_begin = values.end() - quarter;
+  auto first_max = *std::max_element(first_begin, first_begin + quarter);
+  auto last_min = *std::min_element(last_begin, values.end());
+
+  bool ok = last_min <= first_max * tolerance_factor + tolerance;
+  TLOG() << phase << " " << name << ": first quarter max " << first_max << ", last quarter min " << last_min
+         << (ok ? "" : " -> GROWING");
+  return ok;
+}
+
+bool
+check_samples(const std::string& phase, const std::vector<Sample>& samples)
+{
+  std::vector<double> rss, threads, fds;
+  std::map<std::string, std::vector<double>> latencies;
+  for (const auto& s : samples) {
+    rss.push_back(s.rss_kb);
+    threads.push_back(s.threads);
+    fds.push_back(s.fds);
+    for (const auto& [step, value] : s.latencies_ms)
+      latencies[step].push_back(value);
+  }
+
+  bool ok = check_growth(phase, "RSS (kB)", rss, 1., rss_tolerance_kb);
+  ok = check_growth(phase, "threads", threads, 1., 0) && ok;
+  ok = check_growth(phase, "open fds", fds, 1., 0) && ok;
+  for (const auto& [step, values] : latencies)
+    ok = check_growth(phase, step + " (ms)", values, latency_tolerance_factor, latency_tolerance_ms) && ok;
+  return ok;
+}
+
+nlohmann::json
+rc_command(const std::string& id, const std::string& exit_state, int run = 0)
+{
+  dunedaq::rcif::cmd::StartParams start_params;
+  start_params.run = run;
+  nlohmann::json start_param_data;
+  to_json(start_param_data, start_params);
+
+  cmd::AddressedCmd addr_cmd;
+  addr_cmd.data = start_param_data;
+  addr_cmd.match = "";
+  cmd::CmdObj cmd_obj;
+  cmd_obj.modules.push_back(addr_cmd);
+  nlohmann::json data;
+  to_json(data, cmd_obj);
+
+  dunedaq::rcif::cmd::RCCommand cmd;
+  cmd.id = id;
+  cmd.data = data;
+  cmd.exit_state = exit_state;
+  nlohmann::json cmd_data;
+  to_json(cmd_data, cmd);
+  return cmd_data;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  int cycles = argc > 1 ? std::stoi(argv[1]) : 1000;
+  std::string oks_config = argc > 2 ? argv[2] : "oksconflibs:test/config/appSession.data.xml";
+  std::string app_name = argc > 3 ? argv[3] : "TestApp";
+  std::string session_name = argc > 4 ? argv[4] : "test-session";
+  std::string command_file = argc > 5 ? argv[5] : "test/scripts/test.json";
+
+  setenv("DUNEDAQ_PARTITION", "fsm_soak_test", 0);
+
+  TLOG() << "Running " << cycles << " DAQModuleManager init/conf/start/stop/scrap cycles...";
+  std::vector<Sample> manager_samples;
+  for (int i = 0; i < cycles; ++i) {
+    Sample sample;
+    {
+      dunedaq::get_iomanager()->reset();
+      DAQModuleManager mgr;
+      dunedaq::opmonlib::TestOpMonManager opmgr;
+      nlohmann::json cmd_data = nlohmann::json::object();
+      timed(sample, "init", [&]() {
+        mgr.initialize(std::make_shared<ConfigurationManager>(oks_config, app_name, session_name), opmgr);
+      });
+      timed(sample, "conf", [&]() { mgr.execute("conf", cmd_data); });
+      timed(sample, "start", [&]() { mgr.execute("start", cmd_data); });
+      timed(sample, "stop", [&]() { mgr.execute("stop", cmd_data); });
+      timed(sample, "scrap", [&]() {
+        mgr.execute("scrap", cmd_data);
+        mgr.cleanup();
+      });
+    }
+    auto usage = sample_process();
+    sample.rss_kb = usage.rss_kb;
+    sample.threads = usage.threads;
+    sample.fds = usage.fds;
+    manager_samples.push_back(sample);
+  }
+  dunedaq::get_iomanager()->reset();
+
+  TLOG() << "Running " << cycles << " Application conf/start/stop/scrap cycles...";
+  std::vector<Sample> application_samples;
+  {
+    Application app(app_name, session_name, "stdin://" + command_file, oks_config);
+    app.init();
+    for (int i = 0; i < cycles; ++i) {
+      Sample sample;
+      timed(sample, "conf", [&]() { app.execute(rc_command("conf", "CONFIGURED")); });
+      timed(sample, "start", [&]() { app.execute(rc_command("start", "RUNNING", i + 1)); });
+      timed(sample, "stop", [&]() { app.execute(rc_command("stop", "CONFIGURED")); });
+      timed(sample, "scrap", [&]() { app.execute(rc_command("scrap", "INITIAL")); });
+      auto usage = sample_process();
+      sample.rss_kb = usage.rss_kb;
+      sample.threads = usage.threads;
+      sample.fds = usage.fds;
+      application_samples.push_back(sample);
+    }
+  }
+  dunedaq::get_iomanager()->reset();
+
+  bool ok = check_samples("DAQModuleManager", manager_samples);
+  ok = check_samples("Application", application_samples) && ok;
+
+  if (!ok) {
+    TLOG() << "Test failed: resource usage or latencies keep growing";
+    return 1;
+  }
+  TLOG() << "Test complete";
+  return 0;
+}
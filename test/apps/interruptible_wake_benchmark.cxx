@@ -0,0 +1,148 @@
+/**
+ * @file interruptible_wake_benchmark.cxx
+ *
+ * Measures the distribution of the latency between a call to Interruptible::interrupt() and the return of the
+ * interrupted interruptible_wait, for blocking waits and for waits with a spin phase, compared with the
+ * mutex/condition_variable implementation Interruptible used to have.
+ *
+ * A waiter thread repeatedly waits on a condition with a long timeout; the main thread sets the condition and
+ * interrupts it a fixed delay after the wait started, which puts the interrupt within the spin phase if the delay
+ * is shorter than the spin duration.
+ *
+ * Usage: interruptible_wake_benchmark [iterations] [delay us]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/Interruptible.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+constexpr auto wait_timeout = std::chrono::seconds(10);
+
+int64_t
+now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+class FutexWaiter : public Interruptible
+{
+public:
+  explicit FutexWaiter(std::chrono::nanoseconds spin) { set_wait_spin(spin); }
+  bool wait(std::atomic<bool>& condition) { return interruptible_wait(wait_timeout, condition, false); }
+};
+
+// The implementation Interruptible had before, for reference
+class CondVarWaiter
+{
+public:
+  void interrupt()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.notify_all();
+  }
+  bool wait(std::atomic<bool>& condition)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_cv.wait_for(lock, wait_timeout, [&]() { return condition.load(); });
+  }
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
+
+template<typename Waiter>
+std::vector<double>
+measure(Waiter& waiter, int iterations, std::chrono::microseconds delay)
+{
+  std::vector<double> latencies_us;
+  latencies_us.reserve(iterations);
+  std::atomic<bool> condition{ false };
+  std::atomic<int64_t> wait_start_ns{ 0 };
+  std::atomic<int64_t> interrupt_ns{ 0 };
+  std::atomic<bool> done{ false };
+
+  std::thread waiter_thread([&]() {
+    for (int i = 0; i < iterations; ++i) {
+      while (condition.load())
+        std::this_thread::yield();
+      wait_start_ns.store(now_ns());
+      waiter.wait(condition);
+      auto end = now_ns();
+      latencies_us.push_back((end - interrupt_ns.load()) / 1000.);
+      wait_start_ns.store(0);
+      done.store(true);
+    }
+  });
+
+  for (int i = 0; i < iterations; ++i) {
+    int64_t start = 0;
+    while ((start = wait_start_ns.load()) == 0)
+      std::this_thread::yield();
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(start)) + delay);
+    interrupt_ns.store(now_ns());
+    condition.store(true);
+    waiter.interrupt();
+    while (!done.load())
+      std::this_thread::yield();
+    done.store(false);
+    condition.store(false);
+  }
+  waiter_thread.join();
+  return latencies_us;
+}
+
+void
+report(const std::string& name, std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  auto percentile = [&](double fraction) {
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+  };
+  std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10)
+            << percentile(0.5) << std::setw(10) << percentile(0.9) << std::setw(10) << percentile(0.99)
+            << std::setw(10) << percentile(0.999) << std::setw(12) << values.back() << std::endl;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  int iterations = argc > 1 ? std::stoi(argv[1]) : 10000;
+  auto delay = std::chrono::microseconds(argc > 2 ? std::stoi(argv[2]) : 50);
+
+  std::cout << "Wake latency from interrupt() to the return of the wait, in us (" << iterations
+            << " iterations, interrupt " << delay.count() << " us after the wait starts)" << std::endl;
+  std::cout << std::left << std::setw(24) << "implementation" << std::right << std::setw(10) << "p50" << std::setw(10)
+            << "p90" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+
+  {
+    CondVarWaiter waiter;
+    report("condition_variable", measure(waiter, iterations, delay));
+  }
+  for (auto spin_us : { 0, 10, 100, 1000 }) {
+    FutexWaiter waiter{ std::chrono::microseconds(spin_us) };
+    report("futex, spin " + std::to_string(spin_us) + " us", measure(waiter, iterations, delay));
+  }
+  return 0;
+}
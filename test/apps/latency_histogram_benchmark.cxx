@@ -0,0 +1,126 @@
+/**
+ * @file latency_histogram_benchmark.cxx
+ *
+ * Measures the cost of recording one value into a LatencyHistogram, from one thread and from several threads
+ * recording into the same histogram, compared with collecting the samples in a vector behind a mutex (exact
+ * percentiles, as ad-hoc module code often does) and with the two steady_clock::now() calls needed to time the
+ * operation in the first place.
+ *
+ * Usage: latency_histogram_benchmark [records per thread] [max threads]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+// Volatile sink, so that the values computed in the reference loops are not optimised away
+volatile uint64_t g_sink = 0;
+
+// Spread of the recorded values over a few orders of magnitude, without calling a random generator in the loop
+uint64_t
+value(uint64_t i)
+{
+  return 100 + ((i * 2654435761u) & 0xffff);
+}
+
+class Clock
+{
+public:
+  void record(uint64_t)
+  {
+    auto start = std::chrono::steady_clock::now();
+    g_sink = (std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+class Histogram
+{
+public:
+  void record(uint64_t v) { m_histogram.record(v); }
+
+private:
+  LatencyHistogram m_histogram;
+};
+
+class LockedVector
+{
+public:
+  void record(uint64_t v)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_samples.push_back(v);
+  }
+
+private:
+  std::mutex m_mutex;
+  std::vector<uint64_t> m_samples;
+};
+
+// Nanoseconds per record, all the threads recording into the same Recorder
+template<typename Recorder>
+double
+measure(int n_threads, uint64_t records)
+{
+  Recorder recorder;
+  std::atomic<int> ready{ 0 };
+  std::atomic<bool> go{ false };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      ++ready;
+      while (!go.load())
+        std::this_thread::yield();
+      for (uint64_t i = 0; i < records; ++i)
+        recorder.record(value(i + t));
+    });
+  }
+  while (ready.load() < n_threads)
+    std::this_thread::yield();
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  for (auto& thread : threads)
+    thread.join();
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  // Per thread, as seen by the recording code: the threads run in parallel if there are enough cores
+  return elapsed / records * std::min<int>(n_threads, std::max(1u, std::thread::hardware_concurrency())) / n_threads;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  uint64_t records = argc > 1 ? std::stoull(argv[1]) : 10000000;
+  int max_threads = argc > 2 ? std::stoi(argv[2]) : 4;
+
+  std::cout << "Cost of one record in ns, " << records << " records per thread, "
+            << std::thread::hardware_concurrency() << " cores" << std::endl;
+  std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(18) << "2 x clock::now"
+            << std::setw(18) << "LatencyHistogram" << std::setw(18) << "mutex + vector" << std::endl;
+
+  for (int n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    std::cout << std::left << std::setw(10) << n_threads << std::right << std::fixed << std::setprecision(1)
+              << std::setw(18) << measure<Clock>(n_threads, records) << std::setw(18)
+              << measure<Histogram>(n_threads, records) << std::setw(18) << measure<LockedVector>(n_threads, records)
+              << std::endl;
+  }
+  return 0;
+}
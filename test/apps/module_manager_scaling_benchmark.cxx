@@ -0,0 +1,130 @@
+/**
+ * @file module_manager_scaling_benchmark.cxx
+ *
+ * Measures the time taken by DAQModuleManager to initialize and to dispatch commands, for configurations generated
+ * by test/scripts/generate_benchmark_session.py with any number of modules. The results are written as JSON, to
+ * compare runs with different module counts, action plans and addressing regexes.
+ *
+ * Usage: module_manager_scaling_benchmark <oks config> <application> <session> <command data json>
+ *                                         [repetitions] [output json]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "DAQModuleManager.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp" // NOLINT
+#include "opmonlib/TestOpMonManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+const std::vector<std::string> commands = { "conf", "start", "stuff", "stop", "scrap" };
+
+template<typename F>
+double
+time_ms(F&& f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+nlohmann::json
+statistics(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  double sum = 0;
+  for (auto v : values)
+    sum += v;
+  nlohmann::json j;
+  j["mean"] = sum / values.size();
+  j["median"] = values[values.size() / 2];
+  j["min"] = values.front();
+  j["max"] = values.back();
+  return j;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " <oks config> <application> <session> <command data json> [repetitions] [output json]"
+              << std::endl;
+    return 1;
+  }
+  std::string oks_config = argv[1];
+  std::string app_name = argv[2];
+  std::string session_name = argv[3];
+  std::ifstream command_file(argv[4]);
+  if (!command_file.is_open()) {
+    std::cerr << "Cannot open " << argv[4] << std::endl;
+    return 1;
+  }
+  auto command_data = nlohmann::json::parse(command_file);
+  int repetitions = argc > 5 ? std::stoi(argv[5]) : 10;
+  std::string output = argc > 6 ? argv[6] : "";
+
+  setenv("DUNEDAQ_PARTITION", "module_manager_scaling_benchmark", 0);
+
+  std::vector<double> load_ms, initialize_ms;
+  std::map<std::string, std::vector<double>> command_ms;
+  size_t n_modules = 0;
+
+  for (int i = 0; i < repetitions; ++i) {
+    dunedaq::get_iomanager()->reset();
+    DAQModuleManager mgr;
+    dunedaq::opmonlib::TestOpMonManager opmgr;
+
+    std::shared_ptr<ConfigurationManager> cfg_mgr;
+    load_ms.push_back(
+      time_ms([&]() { cfg_mgr = std::make_shared<ConfigurationManager>(oks_config, app_name, session_name); }));
+    initialize_ms.push_back(time_ms([&]() { mgr.initialize(cfg_mgr, opmgr); }));
+
+    for (const auto& cmd : commands) {
+      auto data = command_data.contains(cmd) ? command_data[cmd] : nlohmann::json::object();
+      command_ms[cmd].push_back(time_ms([&]() { mgr.execute(cmd, data); }));
+      n_modules = std::max(n_modules, mgr.get_progress()->modules.size());
+    }
+    mgr.cleanup();
+    TLOG_DEBUG(1) << "Repetition " << i << " done";
+  }
+  dunedaq::get_iomanager()->reset();
+
+  nlohmann::json result;
+  result["configuration"] = oks_config;
+  result["application"] = app_name;
+  result["modules"] = n_modules;
+  result["repetitions"] = repetitions;
+  result["load_configuration_ms"] = statistics(load_ms);
+  result["initialize_ms"] = statistics(initialize_ms);
+  for (const auto& [cmd, values] : command_ms)
+    result["commands_ms"][cmd] = statistics(values);
+
+  if (output.empty()) {
+    std::cout << result.dump(2) << std::endl;
+  } else {
+    std::ofstream ofs(output);
+    ofs << result.dump(2) << std::endl;
+    TLOG() << "Results written to " << output;
+  }
+  return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file opmon_snapshot_benchmark.cxx
+ *
+ * Measures the cost, for a data path thread, of keeping a group of metrics readable by the opmon thread, and how
+ * consistent the values read by the opmon thread are.
+ *
+ * A writer thread updates a struct of counters as fast as it can, keeping all of them equal, while a reader thread
+ * copies the struct at a fixed interval, as generate_opmon_data would. The struct is kept as a plain struct with no
+ * reader (the reference), behind a mutex taken by both threads, as individual relaxed atomics read one by one, and in
+ * an OpMonSnapshot. A read is inconsistent if the counters it returns differ.
+ *
+ * Usage: opmon_snapshot_benchmark [duration ms] [read interval us]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/OpMonSnapshot.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+constexpr size_t n_counters = 8;
+
+struct Counters
+{
+  std::array<uint64_t, n_counters> values;
+};
+
+bool
+consistent(const Counters& counters)
+{
+  for (auto v : counters.values) {
+    if (v != counters.values[0])
+      return false;
+  }
+  return true;
+}
+
+// Volatile sink, so that the writer's stores are not optimised away in the reference case
+volatile uint64_t g_sink = 0;
+
+class Unprotected
+{
+public:
+  void write(uint64_t i)
+  {
+    m_counters.values.fill(i);
+    g_sink = m_counters.values[0];
+  }
+  static constexpr bool has_reader = false;
+  Counters read() { return m_counters; }
+
+private:
+  Counters m_counters{};
+};
+
+class Locked
+{
+public:
+  void write(uint64_t i)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters.values.fill(i);
+  }
+  static constexpr bool has_reader = true;
+  Counters read()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_counters;
+  }
+
+private:
+  std::mutex m_mutex;
+  Counters m_counters{};
+};
+
+class RelaxedAtomics
+{
+public:
+  void write(uint64_t i)
+  {
+    for (auto& v : m_values)
+      v.store(i, std::memory_order_relaxed);
+  }
+  static constexpr bool has_reader = true;
+  Counters read()
+  {
+    Counters counters;
+    for (size_t i = 0; i < n_counters; ++i)
+      counters.values[i] = m_values[i].load(std::memory_order_relaxed);
+    return counters;
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, n_counters> m_values{};
+};
+
+class Snapshot
+{
+public:
+  void write(uint64_t i)
+  {
+    m_snapshot.update([i](Counters& c) { c.values.fill(i); });
+  }
+  static constexpr bool has_reader = true;
+  Counters read() { return m_snapshot.load(); }
+
+private:
+  OpMonSnapshot<Counters> m_snapshot;
+};
+
+template<typename Metrics>
+void
+measure(const std::string& name, std::chrono::milliseconds duration, std::chrono::microseconds read_interval)
+{
+  Metrics metrics;
+  std::atomic<bool> done{ false };
+  uint64_t reads = 0, inconsistent = 0;
+
+  std::thread reader;
+  if (Metrics::has_reader) {
+    reader = std::thread([&]() {
+      auto next = std::chrono::steady_clock::now();
+      while (!done.load(std::memory_order_relaxed)) {
+        if (!consistent(metrics.read()))
+          ++inconsistent;
+        ++reads;
+        if (read_interval.count() > 0) {
+          next += read_interval;
+          std::this_thread::sleep_until(next);
+        }
+      }
+    });
+  }
+
+  uint64_t updates = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + duration;
+  while (std::chrono::steady_clock::now() < end) {
+    // Check the time only every 1024 updates, so that the clock does not dominate the measurement
+    for (int i = 0; i < 1024; ++i)
+      metrics.write(++updates);
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  done = true;
+  if (reader.joinable())
+    reader.join();
+
+  std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(16) << updates / elapsed / 1e6 << std::setw(12) << reads << std::setw(14) << inconsistent
+            << std::endl;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  auto duration = std::chrono::milliseconds(argc > 1 ? std::stoi(argv[1]) : 2000);
+  auto read_interval = std::chrono::microseconds(argc > 2 ? std::stoi(argv[2]) : 100);
+
+  std::cout << "Writer throughput with " << n_counters << " counters, read every " << read_interval.count()
+            << " us for " << duration.count() << " ms" << std::endl;
+  std::cout << std::left << std::setw(20) << "implementation" << std::right << std::setw(16) << "Mupdates/s"
+            << std::setw(12) << "reads" << std::setw(14) << "inconsistent" << std::endl;
+
+  measure<Unprotected>("plain, no reader", duration, read_interval);
+  measure<Locked>("mutex", duration, read_interval);
+  measure<RelaxedAtomics>("relaxed atomics", duration, read_interval);
+  measure<Snapshot>("OpMonSnapshot", duration, read_interval);
+  return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file restart_cycle_benchmark.cxx
+ *
+ * Measures the cost of repeated init/conf/start/stop/scrap cycles of a DAQModuleManager, rebuilding everything at
+ * every cycle (cold) and keeping modules and connections resident (warm).
+ *
+ * Usage: restart_cycle_benchmark [cycles] [oks config] [application] [session]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "DAQModuleManager.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp" // NOLINT
+#include "opmonlib/TestOpMonManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+using timings_t = std::map<std::string, std::vector<double>>;
+
+template<typename F>
+void
+timed(timings_t& timings, const std::string& step, F&& f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  timings[step].push_back(std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+void
+report(const std::string& mode, const timings_t& timings)
+{
+  for (const auto& [step, values] : timings) {
+    double sum = 0;
+    for (auto v : values)
+      sum += v;
+    TLOG() << mode << " " << step << ": mean " << sum / values.size() << " ms, min "
+           << *std::min_element(values.begin(), values.end()) << " ms, max "
+           << *std::max_element(values.begin(), values.end()) << " ms over " << values.size() << " cycles";
+  }
+}
+
+void
+run_cycle(timings_t& timings,
+          DAQModuleManager& mgr,
+          dunedaq::opmonlib::TestOpMonManager& opmgr,
+          std::string oks_config,
+          std::string app_name,
+          std::string session_name)
+{
+  nlohmann::json cmd_data = nlohmann::json::object();
+  timed(timings, "1-init", [&]() {
+    auto cfg_mgr = std::make_shared<ConfigurationManager>(oks_config, app_name, session_name);
+    mgr.initialize(cfg_mgr, opmgr);
+  });
+  timed(timings, "2-conf", [&]() { mgr.execute("conf", cmd_data); });
+  timed(timings, "3-start", [&]() { mgr.execute("start", cmd_data); });
+  timed(timings, "4-stop", [&]() { mgr.execute("stop", cmd_data); });
+  timed(timings, "5-scrap", [&]() {
+    mgr.execute("scrap", cmd_data);
+    mgr.cleanup();
+  });
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  int cycles = argc > 1 ? std::stoi(argv[1]) : 100;
+  std::string oks_config = argc > 2 ? argv[2] : "oksconflibs:test/config/appSession.data.xml";
+  std::string app_name = argc > 3 ? argv[3] : "TestApp";
+  std::string session_name = argc > 4 ? argv[4] : "test-session";
+
+  setenv("DUNEDAQ_PARTITION", "restart_cycle_benchmark", 0);
+
+  TLOG() << "Running " << cycles << " cold cycles...";
+  timings_t cold;
+  for (int i = 0; i < cycles; ++i) {
+    dunedaq::get_iomanager()->reset();
+    DAQModuleManager mgr;
+    dunedaq::opmonlib::TestOpMonManager opmgr;
+    run_cycle(cold, mgr, opmgr, oks_config, app_name, session_name);
+  }
+
+  TLOG() << "Running " << cycles << " warm cycles...";
+  timings_t warm;
+  dunedaq::get_iomanager()->reset();
+  {
+    DAQModuleManager mgr;
+    mgr.set_warm_restart(true);
+    dunedaq::opmonlib::TestOpMonManager opmgr;
+    for (int i = 0; i < cycles; ++i) {
+      run_cycle(warm, mgr, opmgr, oks_config, app_name, session_name);
+    }
+  }
+  dunedaq::get_iomanager()->reset();
+
+  report("cold", cold);
+  report("warm", warm);
+
+  TLOG() << "Test complete";
+}
@@ -0,0 +1,110 @@
+/**
+ * @file sharded_counter_benchmark.cxx
+ *
+ * Measures the total update rate of a counter incremented by several threads at once, for a single std::atomic
+ * shared by all the threads and for a ShardedCounter, with a reader summing the value at a fixed interval as
+ * generate_opmon_data would. The contention on the shared atomic only shows when the threads run on different
+ * cores, so the benchmark should be run on a machine with at least as many cores as threads.
+ *
+ * Usage: sharded_counter_benchmark [duration ms] [max threads]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ShardedCounter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+constexpr auto read_interval = std::chrono::milliseconds(1);
+
+class SharedAtomic
+{
+public:
+  void increment() { m_value.fetch_add(1, std::memory_order_relaxed); }
+  uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+  alignas(64) std::atomic<uint64_t> m_value{ 0 };
+};
+
+class Sharded
+{
+public:
+  void increment() { m_counter.increment(); }
+  uint64_t value() const { return m_counter.value(); }
+
+private:
+  ShardedCounter m_counter;
+};
+
+// Millions of increments per second, over all the threads
+template<typename Counter>
+double
+measure(int n_threads, std::chrono::milliseconds duration)
+{
+  Counter counter;
+  std::atomic<bool> go{ false }, done{ false };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&]() {
+      while (!go.load())
+        std::this_thread::yield();
+      while (!done.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 1024; ++i)
+          counter.increment();
+      }
+    });
+  }
+  std::thread reader([&]() {
+    while (!done.load()) {
+      volatile uint64_t value = counter.value();
+      (void)value;
+      std::this_thread::sleep_for(read_interval);
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  std::this_thread::sleep_for(duration);
+  done = true;
+  for (auto& thread : threads)
+    thread.join();
+  reader.join();
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return counter.value() / elapsed / 1e6;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  auto duration = std::chrono::milliseconds(argc > 1 ? std::stoi(argv[1]) : 1000);
+  int max_threads = argc > 2 ? std::stoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+
+  std::cout << "Total increments per second, in millions (" << std::thread::hardware_concurrency() << " cores, "
+            << detail::default_shards() << " shards, value read every " << read_interval.count() << " ms)"
+            << std::endl;
+  std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(16) << "std::atomic"
+            << std::setw(16) << "ShardedCounter" << std::endl;
+
+  for (int n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    std::cout << std::left << std::setw(10) << n_threads << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << measure<SharedAtomic>(n_threads, duration) << std::setw(16)
+              << measure<Sharded>(n_threads, duration) << std::endl;
+  }
+  return 0;
+}
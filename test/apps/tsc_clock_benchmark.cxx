@@ -0,0 +1,70 @@
+/**
+ * @file tsc_clock_benchmark.cxx
+ *
+ * Measures the cost of taking a timestamp with std::chrono::steady_clock and with TscClock, and the cost of timing
+ * an operation into a LatencyHistogram with each of them.
+ *
+ * Usage: tsc_clock_benchmark [iterations]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/LatencyHistogram.hpp"
+#include "appfwk/TscClock.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+// Volatile sink, so that the timestamps are not optimised away
+volatile uint64_t g_sink = 0;
+
+template<typename Operation>
+void
+measure(const std::string& name, uint64_t iterations, Operation&& operation)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; ++i)
+    operation();
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << elapsed / iterations << std::endl;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  uint64_t iterations = argc > 1 ? std::stoull(argv[1]) : 10000000;
+
+  TscClock::calibrate();
+  std::cout << "TSC " << (TscClock::uses_tsc() ? "used" : "not available, TscClock uses steady_clock") << ", "
+            << TscClock::ticks_per_ns() << " ticks per ns" << std::endl;
+  std::cout << std::left << std::setw(40) << "operation" << std::right << std::setw(10) << "ns" << std::endl;
+
+  measure("steady_clock::now()", iterations, []() {
+    g_sink = std::chrono::steady_clock::now().time_since_epoch().count();
+  });
+  measure("TscClock::now()", iterations, []() { g_sink = TscClock::now(); });
+  measure("TscClock::to_ns()", iterations, []() { g_sink = TscClock::to_ns(g_sink); });
+
+  LatencyHistogram histogram;
+  measure("time into histogram with steady_clock", iterations, [&histogram]() {
+    auto start = std::chrono::steady_clock::now();
+    histogram.record(std::chrono::steady_clock::now() - start);
+  });
+  measure("time into histogram with TscClock", iterations, [&histogram]() {
+    auto start = TscClock::now();
+    histogram.record_since(start);
+  });
+  return 0;
+}
@@ -1,7 +1,10 @@
 /**
  * @file DummyModule.hpp
  *
- * DummyModule is a simple DAQModule implementation that responds to a "stuff" command with a log message.
+ * DummyModule is a simple DAQModule implementation that responds to a "stuff" command with a log message, and
+ * accepts the conf, start, stop and scrap transitions without doing anything. Its "slow_stuff" command waits for
+ * the duration given in its "wait_ms" data (10 s by default) unless the command is cancelled, or fails at once if
+ * its "fail" data is true.
  *
  * This is part of the DUNE DAQ Application Framework, copyright 2020.
  * Licensing/copyright details are in the COPYING file that you should have
@@ -12,9 +15,12 @@
 #define APPFWK_TEST_PLUGINS_DUMMYMODULE_HPP_
 
 #include "appfwk/DAQModule.hpp"
+#include "appfwk/Interruptible.hpp"
 
 #include "ers/ers.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -45,17 +51,35 @@ public:
   virtual void do_stuff(const data_t& /*data*/) = 0;
 };
 
-class DummyModule : public DummyParentModule
+class DummyModule
+  : public DummyParentModule
+  , public Interruptible
 {
 public:
   explicit DummyModule(const std::string& name)
     : DummyParentModule(name)
   {
     register_command("bad_stuff", &DummyModule::do_bad_stuff);
+    register_command("slow_stuff", &DummyModule::do_slow_stuff);
+    for (auto transition : { "conf", "start", "stop", "scrap" })
+      register_command(transition, &DummyModule::do_transition);
   }
 
+  void do_transition(const data_t&) {}
+
   void do_bad_stuff(const data_t&) { throw DummyModuleUpdate(ERS_HERE, get_name(), "DummyModule do_bad_stuff"); }
 
+  void do_slow_stuff(const data_t& data, const CancellationToken& token)
+  {
+    if (data.value("fail", false))
+      throw DummyModuleUpdate(ERS_HERE, get_name(), "DummyModule do_slow_stuff failed");
+    std::atomic<bool> never{ false };
+    auto wait_ms = data.value("wait_ms", 10000);
+    interruptible_wait(std::chrono::milliseconds(wait_ms), never, token);
+    if (token.stop_requested())
+      throw DummyModuleUpdate(ERS_HERE, get_name(), "DummyModule do_slow_stuff cancelled: " + token.reason());
+  }
+
   void do_stuff(const data_t& /*data*/) override
   {
     ers::info(DummyModuleUpdate(ERS_HERE, get_name(), "DummyModule do_stuff"));
@@ -0,0 +1,158 @@
+/**
+ * @file LoadGeneratorModule.cpp LoadGeneratorModule class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "LoadGeneratorModule.hpp"
+
+#include "appfwk/ModuleConfiguration.hpp"
+#include "appfwk/dal/LoadAction.hpp"
+#include "appfwk/dal/LoadGeneratorModule.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+LoadGeneratorModule::LoadGeneratorModule(const std::string& name)
+  : DAQModule(name)
+{
+  register_command("conf", &LoadGeneratorModule::do_conf);
+  register_command("start", &LoadGeneratorModule::do_start);
+  register_command("stop", &LoadGeneratorModule::do_stop);
+  register_command("scrap", &LoadGeneratorModule::do_scrap);
+}
+
+void
+LoadGeneratorModule::init(std::shared_ptr<ModuleConfiguration> mcfg)
+{
+  auto conf = mcfg->module<dal::LoadGeneratorModule>(get_name());
+  if (conf == nullptr) {
+    throw CommandFailed(ERS_HERE, "init", get_name(), "no LoadGeneratorModule configuration");
+  }
+
+  m_random.seed(conf->get_seed() != 0 ? conf->get_seed() : std::random_device()());
+  m_actions.clear();
+  for (auto action : conf->get_actions()) {
+    m_actions[action->get_command()].push_back(Action{ action->get_load(),
+                                                       action->get_distribution(),
+                                                       action->get_mean_ms(),
+                                                       action->get_spread_ms(),
+                                                       action->get_memory_bytes(),
+                                                       action->get_file_path(),
+                                                       action->get_failure_probability() });
+  }
+
+  run_actions("init");
+}
+
+void
+LoadGeneratorModule::do_scrap(const data_t&)
+{
+  // The memory loads are released even if a scrap action fails
+  try {
+    run_actions("scrap");
+  } catch (...) {
+    m_allocations.clear();
+    throw;
+  }
+  m_allocations.clear();
+}
+
+void
+LoadGeneratorModule::run_actions(const std::string& cmd)
+{
+  auto actions = m_actions.find(cmd);
+  if (actions == m_actions.end())
+    return;
+
+  for (const auto& action : actions->second) {
+    generate_load(cmd, action);
+    if (draw_failure(action.failure_probability)) {
+      throw LoadGeneratorFailure(ERS_HERE, get_name(), cmd, action.failure_probability);
+    }
+  }
+}
+
+void
+LoadGeneratorModule::generate_load(const std::string& cmd, const Action& action)
+{
+  if (action.load == "cpu") {
+    auto duration = std::chrono::duration<double, std::milli>(draw_duration_ms(action));
+    TLOG_DEBUG(2) << get_name() << " " << cmd << ": busy for " << duration.count() << " ms";
+    auto end = std::chrono::steady_clock::now() + duration;
+    volatile uint64_t sink = 0;
+    while (std::chrono::steady_clock::now() < end) {
+      for (int i = 0; i < 1000; ++i)
+        sink = sink * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+  } else if (action.load == "sleep") {
+    auto duration = std::chrono::duration<double, std::milli>(draw_duration_ms(action));
+    TLOG_DEBUG(2) << get_name() << " " << cmd << ": sleeping for " << duration.count() << " ms";
+    std::this_thread::sleep_for(duration);
+  } else if (action.load == "memory") {
+    TLOG_DEBUG(2) << get_name() << " " << cmd << ": allocating " << action.memory_bytes << " bytes";
+    std::unique_ptr<char[]> buffer(new char[action.memory_bytes]);
+    // Touch every page so that the memory is actually resident
+    auto page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    for (uint64_t offset = 0; offset < action.memory_bytes; offset += page)
+      buffer[offset] = 1;
+    m_allocations.push_back(std::move(buffer));
+  } else if (action.load == "file") {
+    std::string fname = action.file_path + "/" + get_name() + "_" + cmd + "_" + std::to_string(getpid()) + ".load";
+    TLOG_DEBUG(2) << get_name() << " " << cmd << ": writing " << action.memory_bytes << " bytes to " << fname;
+    std::vector<char> block(std::min<uint64_t>(action.memory_bytes, 1 << 20), 'x');
+    {
+      std::ofstream ofs(fname, std::ios::binary);
+      if (!ofs.is_open()) {
+        throw CommandFailed(ERS_HERE, cmd, get_name(), "cannot write " + fname);
+      }
+      for (uint64_t written = 0; written < action.memory_bytes; written += block.size())
+        ofs.write(block.data(), std::min<uint64_t>(block.size(), action.memory_bytes - written));
+    }
+    std::remove(fname.c_str());
+  }
+}
+
+double
+LoadGeneratorModule::draw_duration_ms(const Action& action)
+{
+  const std::lock_guard<std::mutex> lock(m_random_mutex);
+  double value = action.mean_ms;
+  if (action.distribution == "uniform") {
+    value = std::uniform_real_distribution<double>(action.mean_ms - action.spread_ms,
+                                                   action.mean_ms + action.spread_ms)(m_random);
+  } else if (action.distribution == "normal" && action.spread_ms > 0) {
+    value = std::normal_distribution<double>(action.mean_ms, action.spread_ms)(m_random);
+  } else if (action.distribution == "exponential" && action.mean_ms > 0) {
+    value = std::exponential_distribution<double>(1. / action.mean_ms)(m_random);
+  }
+  return std::max(0., value);
+}
+
+bool
+LoadGeneratorModule::draw_failure(double probability)
+{
+  if (probability <= 0)
+    return false;
+  const std::lock_guard<std::mutex> lock(m_random_mutex);
+  return std::uniform_real_distribution<double>(0., 1.)(m_random) < probability;
+}
+
+} // namespace appfwk
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::appfwk::LoadGeneratorModule)
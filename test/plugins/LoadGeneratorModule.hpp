@@ -0,0 +1,80 @@
+/**
+ * @file LoadGeneratorModule.hpp
+ *
+ * LoadGeneratorModule is a test DAQModule whose init, conf, start, stop and scrap handlers generate a configurable
+ * load (busy CPU, sleep, memory allocation or file writes, with durations drawn from a distribution) and can fail
+ * with a given probability. It imitates the behaviour of real modules when benchmarking the framework.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_TEST_PLUGINS_LOADGENERATORMODULE_HPP_
+#define APPFWK_TEST_PLUGINS_LOADGENERATORMODULE_HPP_
+
+#include "appfwk/DAQModule.hpp"
+
+#include "ers/ers.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+
+// Disable coverage collection LCOV_EXCL_START
+ERS_DECLARE_ISSUE_BASE(appfwk,
+                       LoadGeneratorFailure,
+                       appfwk::GeneralDAQModuleIssue,
+                       "Simulated failure of command " << cmd << " (probability " << probability << ")",
+                       ((std::string)name),
+                       ((std::string)cmd)((double)probability))
+// Re-enable coverage collection LCOV_EXCL_STOP
+
+namespace appfwk {
+
+class LoadGeneratorModule : public DAQModule
+{
+public:
+  explicit LoadGeneratorModule(const std::string& name);
+
+  void init(std::shared_ptr<ModuleConfiguration> mcfg) override;
+
+private:
+  // Copy of a dal::LoadAction, so that the handlers do not depend on the configuration database
+  struct Action
+  {
+    std::string load;
+    std::string distribution;
+    double mean_ms;
+    double spread_ms;
+    uint64_t memory_bytes;
+    std::string file_path;
+    double failure_probability;
+  };
+
+  void do_conf(const data_t&) { run_actions("conf"); }
+  void do_start(const data_t&) { run_actions("start"); }
+  void do_stop(const data_t&) { run_actions("stop"); }
+  void do_scrap(const data_t&);
+
+  void run_actions(const std::string& cmd);
+  void generate_load(const std::string& cmd, const Action& action);
+  double draw_duration_ms(const Action& action);
+  bool draw_failure(double probability);
+
+  std::map<std::string, std::vector<Action>> m_actions; // by command
+  std::mt19937_64 m_random;
+  std::mutex m_random_mutex;
+  std::vector<std::unique_ptr<char[]>> m_allocations; // memory loads, released at scrap
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_TEST_PLUGINS_LOADGENERATORMODULE_HPP_
@@ -0,0 +1,129 @@
+/**
+ * @file ThroughputConsumer.cpp ThroughputConsumer class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "ThroughputConsumer.hpp"
+
+#include "appfwk/ModuleConfiguration.hpp"
+#include "appfwk/dal/ThroughputConsumer.hpp"
+#include "appfwk/opmon/throughput.pb.h"
+
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+ThroughputConsumer::ThroughputConsumer(const std::string& name)
+  : DAQModule(name)
+{
+  register_command("conf", &ThroughputConsumer::do_transition);
+  register_command("start", &ThroughputConsumer::do_start);
+  register_command("stop", &ThroughputConsumer::do_stop);
+  register_command("scrap", &ThroughputConsumer::do_transition);
+}
+
+void
+ThroughputConsumer::init(std::shared_ptr<ModuleConfiguration> mcfg)
+{
+  auto conf = mcfg->module<dal::ThroughputConsumer>(get_name());
+  if (conf == nullptr) {
+    throw CommandFailed(ERS_HERE, "init", get_name(), "no ThroughputConsumer configuration");
+  }
+  if (conf->get_inputs().size() != 1) {
+    throw CommandFailed(ERS_HERE, "init", get_name(), "a ThroughputConsumer needs exactly one input");
+  }
+
+  m_receiver = get_iom_receiver<ThroughputPayload>(conf->get_inputs()[0]->UID());
+  m_receive_timeout = std::chrono::milliseconds(conf->get_receive_timeout_ms());
+  // Only a consumer with an input has a receiving thread. Registered again when the module is initialised again.
+  m_thread = &register_thread("receive", &ThroughputConsumer::receive_one);
+  m_thread->set_affinity(conf->get_cpu() >= 0 ? std::vector<int>{ conf->get_cpu() } : std::vector<int>{});
+}
+
+void
+ThroughputConsumer::do_start(const data_t&)
+{
+  m_run_start_messages = m_received_messages.load();
+  m_run_start_bytes = m_received_bytes.load();
+  m_run_start_latency = m_latency.snapshot();
+  m_run_start_time = std::chrono::steady_clock::now();
+}
+
+void
+ThroughputConsumer::do_stop(const data_t&)
+{
+  // The receiving thread is already stopped. Drain the payloads still in the queue, so that they do not end up in the next run
+  while (auto payload = m_receiver->try_receive(std::chrono::milliseconds(0)))
+    count(*payload);
+
+  auto messages = m_received_messages.load() - m_run_start_messages;
+  auto bytes = m_received_bytes.load() - m_run_start_bytes;
+  double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_run_start_time).count();
+  auto latency = m_latency.summary_since(m_run_start_latency);
+  TLOG() << get_name() << ": received " << messages << " payloads, " << bytes << " bytes in " << elapsed_s
+         << " s: " << messages / elapsed_s << " messages/s, " << bytes / elapsed_s << " bytes/s, latency p50 "
+         << latency.p50 / 1000. << " us, p99 " << latency.p99 / 1000. << " us, p99.9 " << latency.p999 / 1000.
+         << " us";
+}
+
+bool
+ThroughputConsumer::receive_one()
+{
+  auto payload = m_receiver->try_receive(m_receive_timeout);
+  if (payload)
+    count(*payload);
+  return true;
+}
+
+void
+ThroughputConsumer::count(const ThroughputPayload& payload)
+{
+  auto latency_ns = static_cast<uint64_t>(std::max<int64_t>(0, throughput_clock_ns() - payload.sent_ns));
+  m_latency.record(latency_ns);
+  m_received_bytes.fetch_add(payload.data.size(), std::memory_order_relaxed);
+  m_received_messages.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+ThroughputConsumer::generate_opmon_data()
+{
+  auto now = std::chrono::steady_clock::now();
+  auto messages = m_received_messages.load(std::memory_order_relaxed);
+  auto bytes = m_received_bytes.load(std::memory_order_relaxed);
+  double elapsed_s = std::chrono::duration<double>(now - m_report_time).count();
+
+  opmon::ThroughputConsumerInfo info;
+  info.set_received_messages(messages);
+  info.set_received_bytes(bytes);
+  if (elapsed_s > 0) {
+    info.set_messages_per_s((messages - m_reported_messages) / elapsed_s);
+    info.set_bytes_per_s((bytes - m_reported_bytes) / elapsed_s);
+  }
+  auto latency = m_latency.interval_summary();
+  info.set_latency_p50_us(latency.p50 / 1000.);
+  info.set_latency_p90_us(latency.p90 / 1000.);
+  info.set_latency_p99_us(latency.p99 / 1000.);
+  info.set_latency_p999_us(latency.p999 / 1000.);
+  info.set_latency_max_us(latency.max / 1000.);
+
+  m_reported_messages = messages;
+  m_reported_bytes = bytes;
+  m_report_time = now;
+
+  publish(std::move(info));
+}
+
+} // namespace appfwk
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::appfwk::ThroughputConsumer)
@@ -0,0 +1,74 @@
+/**
+ * @file ThroughputConsumer.hpp
+ *
+ * ThroughputConsumer is a test DAQModule which, while running, receives the ThroughputPayloads sent by
+ * ThroughputProducers from its input queue, and reports the message and byte rates and the distribution of the
+ * transfer latency.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_TEST_PLUGINS_THROUGHPUTCONSUMER_HPP_
+#define APPFWK_TEST_PLUGINS_THROUGHPUTCONSUMER_HPP_
+
+#include "ThroughputPayload.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/LatencyHistogram.hpp"
+
+#include "iomanager/Receiver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace dunedaq {
+namespace appfwk {
+
+class ThroughputConsumer : public DAQModule
+{
+public:
+  explicit ThroughputConsumer(const std::string& name);
+
+  void init(std::shared_ptr<ModuleConfiguration> mcfg) override;
+
+protected:
+  void generate_opmon_data() override;
+
+private:
+  void do_start(const data_t&);
+  void do_stop(const data_t&);
+  void do_transition(const data_t&) {}
+
+  bool receive_one();
+  void count(const ThroughputPayload& payload);
+
+  std::shared_ptr<iomanager::ReceiverConcept<ThroughputPayload>> m_receiver;
+  std::chrono::milliseconds m_receive_timeout;
+
+  ModuleThread* m_thread = nullptr; // owned by DAQModule
+  // Counters since init, written by the worker thread and read by the opmon thread
+  std::atomic<uint64_t> m_received_messages{ 0 };
+  std::atomic<uint64_t> m_received_bytes{ 0 };
+  LatencyHistogram m_latency; // in ns
+
+  // Counters at the start of the run, for the summary printed at stop
+  uint64_t m_run_start_messages = 0;
+  uint64_t m_run_start_bytes = 0;
+  LatencyHistogram::Snapshot m_run_start_latency;
+  std::chrono::steady_clock::time_point m_run_start_time;
+
+  // State of the previous opmon report, to compute rates
+  uint64_t m_reported_messages = 0;
+  uint64_t m_reported_bytes = 0;
+  std::chrono::steady_clock::time_point m_report_time = std::chrono::steady_clock::now();
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_TEST_PLUGINS_THROUGHPUTCONSUMER_HPP_
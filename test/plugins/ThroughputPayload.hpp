@@ -0,0 +1,46 @@
+/**
+ * @file ThroughputPayload.hpp
+ *
+ * ThroughputPayload is the fixed-size message sent by ThroughputProducer to ThroughputConsumer through IOManager
+ * queues. It carries a sequence number and its send time, so that the consumer can measure the transfer latency.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_TEST_PLUGINS_THROUGHPUTPAYLOAD_HPP_
+#define APPFWK_TEST_PLUGINS_THROUGHPUTPAYLOAD_HPP_
+
+#include "serialization/Serialization.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+struct ThroughputPayload
+{
+  uint64_t sequence = 0;
+  int64_t sent_ns = 0; // steady_clock time at which the payload was sent
+  std::vector<char> data;
+
+  DUNE_DAQ_SERIALIZE(ThroughputPayload, sequence, sent_ns, data);
+};
+
+inline int64_t
+throughput_clock_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+} // namespace appfwk
+
+DUNE_DAQ_SERIALIZABLE(appfwk::ThroughputPayload, "ThroughputPayload");
+
+} // namespace dunedaq
+
+#endif // APPFWK_TEST_PLUGINS_THROUGHPUTPAYLOAD_HPP_
@@ -0,0 +1,114 @@
+/**
+ * @file ThroughputProducer.cpp ThroughputProducer class implementation
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "ThroughputProducer.hpp"
+
+#include "appfwk/ModuleConfiguration.hpp"
+#include "appfwk/dal/ThroughputProducer.hpp"
+#include "appfwk/opmon/throughput.pb.h"
+
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace appfwk {
+
+ThroughputProducer::ThroughputProducer(const std::string& name)
+  : DAQModule(name)
+{
+  m_thread = &register_thread("send", &ThroughputProducer::send_one);
+  register_command("conf", &ThroughputProducer::do_transition);
+  register_command("start", &ThroughputProducer::do_start);
+  register_command("stop", &ThroughputProducer::do_stop);
+  register_command("scrap", &ThroughputProducer::do_transition);
+}
+
+void
+ThroughputProducer::init(std::shared_ptr<ModuleConfiguration> mcfg)
+{
+  auto conf = mcfg->module<dal::ThroughputProducer>(get_name());
+  if (conf == nullptr) {
+    throw CommandFailed(ERS_HERE, "init", get_name(), "no ThroughputProducer configuration");
+  }
+  if (conf->get_outputs().size() != 1) {
+    throw CommandFailed(ERS_HERE, "init", get_name(), "a ThroughputProducer needs exactly one output");
+  }
+
+  m_sender = get_iom_sender<ThroughputPayload>(conf->get_outputs()[0]->UID());
+  m_payload_bytes = conf->get_payload_bytes();
+  m_max_messages = conf->get_max_messages();
+  m_send_timeout = std::chrono::milliseconds(conf->get_send_timeout_ms());
+  m_thread->set_affinity(conf->get_cpu() >= 0 ? std::vector<int>{ conf->get_cpu() } : std::vector<int>{});
+}
+
+void
+ThroughputProducer::do_start(const data_t&)
+{
+  auto counters = m_counters.load();
+  m_run_start_messages = counters.sent_messages;
+  m_run_start_timeouts = counters.send_timeouts;
+  m_sequence = 0;
+}
+
+void
+ThroughputProducer::do_stop(const data_t&)
+{
+  auto counters = m_counters.load();
+  TLOG() << get_name() << ": sent " << counters.sent_messages - m_run_start_messages << " payloads of "
+         << m_payload_bytes << " bytes, " << counters.send_timeouts - m_run_start_timeouts << " send timeouts";
+}
+
+bool
+ThroughputProducer::send_one()
+{
+  if (m_max_messages != 0 && m_sequence >= m_max_messages)
+    return false;
+
+  ThroughputPayload payload;
+  payload.sequence = m_sequence;
+  payload.data.resize(m_payload_bytes);
+  payload.sent_ns = throughput_clock_ns();
+  if (m_sender->try_send(std::move(payload), m_send_timeout)) {
+    ++m_sequence;
+    m_counters.update([](Counters& c) { ++c.sent_messages; });
+  } else {
+    m_counters.update([](Counters& c) { ++c.send_timeouts; });
+  }
+  return true;
+}
+
+void
+ThroughputProducer::generate_opmon_data()
+{
+  auto now = std::chrono::steady_clock::now();
+  auto counters = m_counters.load();
+  auto sent = counters.sent_messages;
+  double elapsed_s = std::chrono::duration<double>(now - m_report_time).count();
+
+  opmon::ThroughputProducerInfo info;
+  info.set_sent_messages(sent);
+  info.set_sent_bytes(sent * m_payload_bytes);
+  info.set_send_timeouts(counters.send_timeouts);
+  if (elapsed_s > 0) {
+    info.set_messages_per_s((sent - m_reported_messages) / elapsed_s);
+    info.set_bytes_per_s((sent - m_reported_messages) * m_payload_bytes / elapsed_s);
+  }
+  m_reported_messages = sent;
+  m_report_time = now;
+
+  publish(std::move(info));
+}
+
+} // namespace appfwk
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::appfwk::ThroughputProducer)
@@ -0,0 +1,74 @@
+/**
+ * @file ThroughputProducer.hpp
+ *
+ * ThroughputProducer is a test DAQModule which, while running, sends fixed-size ThroughputPayloads to its output
+ * queue as fast as the queue accepts them. Together with ThroughputConsumer it measures the data throughput of the
+ * IOManager queues inside one application.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef APPFWK_TEST_PLUGINS_THROUGHPUTPRODUCER_HPP_
+#define APPFWK_TEST_PLUGINS_THROUGHPUTPRODUCER_HPP_
+
+#include "ThroughputPayload.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/OpMonSnapshot.hpp"
+
+#include "iomanager/Sender.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace dunedaq {
+namespace appfwk {
+
+class ThroughputProducer : public DAQModule
+{
+public:
+  explicit ThroughputProducer(const std::string& name);
+
+  void init(std::shared_ptr<ModuleConfiguration> mcfg) override;
+
+protected:
+  void generate_opmon_data() override;
+
+private:
+  void do_start(const data_t&);
+  void do_stop(const data_t&);
+  void do_transition(const data_t&) {}
+
+  bool send_one();
+
+  std::shared_ptr<iomanager::SenderConcept<ThroughputPayload>> m_sender;
+  uint32_t m_payload_bytes = 0;
+  uint64_t m_max_messages = 0; // 0 for no limit
+  std::chrono::milliseconds m_send_timeout;
+
+  ModuleThread* m_thread = nullptr; // owned by DAQModule
+  uint64_t m_sequence = 0;          // of the next payload in the run
+
+  // Since init, updated by m_thread and read by the opmon thread
+  struct Counters
+  {
+    uint64_t sent_messages;
+    uint64_t send_timeouts;
+  };
+  OpMonSnapshot<Counters> m_counters;
+  uint64_t m_run_start_messages = 0;
+  uint64_t m_run_start_timeouts = 0;
+
+  // State of the previous opmon report, to compute rates
+  uint64_t m_reported_messages = 0;
+  std::chrono::steady_clock::time_point m_report_time = std::chrono::steady_clock::now();
+};
+
+} // namespace appfwk
+} // namespace dunedaq
+
+#endif // APPFWK_TEST_PLUGINS_THROUGHPUTPRODUCER_HPP_
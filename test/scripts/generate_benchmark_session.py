@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+Generate an OKS session with an arbitrary number of DummyModules, to measure
+how DAQModuleManager scales with the number of modules, together with the
+command data addressing the modules through regular expressions.
+
+The generated database includes test/config/appSession.data.xml and defines
+the DaqApplication BenchApp in the session bench-session. It is meant to be
+used with the module_manager_scaling_benchmark test application, e.g.:
+
+  generate_benchmark_session.py --modules 1000 --steps 4 --regexes 10 -o bench
+  module_manager_scaling_benchmark oksconflibs:bench.data.xml BenchApp bench-session bench.commands.json
+"""
+
+import argparse
+import json
+from xml.sax.saxutils import quoteattr
+
+COMMANDS = ["conf", "start", "stuff", "stop", "scrap"]
+
+HEADER = """<?xml version="1.0" encoding="ASCII"?>
+
+<!-- oks-data version 2.2 -->
+
+<oks-data>
+
+<info name="" type="" num-of-items="{items}" oks-format="data" oks-version="862f2957270" created-by="generate_benchmark_session.py"/>
+
+<include>
+ <file path="{include}"/>
+</include>
+
+"""
+
+
+def obj(cls, uid, attrs=(), rels=()):
+    lines = [f'<obj class="{cls}" id={quoteattr(uid)}>']
+    for name, typ, val in attrs:
+        if isinstance(val, list):
+            lines.append(f' <attr name="{name}" type="{typ}">')
+            lines += [f'  <data val={quoteattr(str(v))}/>' for v in val]
+            lines.append(' </attr>')
+        else:
+            lines.append(f' <attr name="{name}" type="{typ}" val={quoteattr(str(val))}/>')
+    for name, refs in rels:
+        if isinstance(refs, list):
+            lines.append(f' <rel name="{name}">')
+            lines += [f'  <ref class="{c}" id={quoteattr(i)}/>' for c, i in refs]
+            lines.append(' </rel>')
+        else:
+            c, i = refs
+            lines.append(f' <rel name="{name}" class="{c}" id={quoteattr(i)}/>')
+    lines.append('</obj>\n')
+    return "\n".join(lines)
+
+
+def module_name(i, width):
+    return f"bench_mod_{i:0{width}d}"
+
+
+def generate(args):
+    width = len(str(args.modules - 1))
+    modules = [module_name(i, width) for i in range(args.modules)]
+    objects = [obj("DummyModule", m) for m in modules]
+
+    # Action plan steps: either one group by type, or the modules split into groups by id
+    if args.group_by == "type":
+        steps = [("DaqModulesGroupByType", "bench_group_type")]
+        objects.append(obj("DaqModulesGroupByType", "bench_group_type", attrs=[("modules", "class", ["DummyModule"])]))
+    else:
+        steps = []
+        n_steps = max(1, min(args.steps, args.modules))
+        for s in range(n_steps):
+            uid = f"bench_group_{s}"
+            members = modules[s::n_steps]
+            steps.append(("DaqModulesGroupById", uid))
+            objects.append(obj("DaqModulesGroupById", uid, rels=[("modules", [("DummyModule", m) for m in members])]))
+
+    plans = []
+    for cmd in COMMANDS:
+        uid = f"bench_plan_{cmd}"
+        plans.append(("ActionPlan", uid))
+        objects.append(obj("ActionPlan", uid,
+                           attrs=[("execution_policy", "enum", args.policy)],
+                           rels=[("command", ("FSMCommand", cmd)), ("steps", steps)]))
+
+    objects.append(obj("DaqApplication", "BenchApp",
+                       attrs=[("application_name", "string", "daq_application")],
+                       rels=[("runs_on", ("VirtualHost", "vlocalhost")),
+                             ("opmon_conf", ("OpMonConf", "slow-all-monitoring")),
+                             ("modules", [("DummyModule", m) for m in modules]),
+                             ("action_plans", plans)]))
+    objects.append(obj("Segment", "bench-segment",
+                       rels=[("applications", [("DaqApplication", "BenchApp")]),
+                             ("controller", ("RCApplication", "my-controller"))]))
+    objects.append(obj("Session", "bench-session",
+                       attrs=[("data_request_timeout_ms", "u32", 1000),
+                              ("data_rate_slowdown_factor", "u32", 1),
+                              ("controller_log_level", "enum", "INFO")],
+                       rels=[("environment", [("VariableSet", "common-env")]),
+                             ("segment", ("Segment", "bench-segment")),
+                             ("detector_configuration", ("DetectorConfig", "dummy-detector")),
+                             ("opmon_uri", ("OpMonURI", "local-opmon-uri"))]))
+
+    with open(args.output + ".data.xml", "w") as f:
+        f.write(HEADER.format(items=len(objects), include=args.include))
+        f.write("\n".join(objects))
+        f.write("</oks-data>\n")
+
+    # Command data: every regex addresses the modules whose number starts with a given prefix, using prefixes just
+    # long enough to get the requested number of regexes. The remaining modules are addressed by an empty match if
+    # --catch-all is given.
+    addressed = []
+    if args.regexes > 0:
+        prefixes = []
+        for length in range(1, width + 1):
+            prefixes = sorted({m[len("bench_mod_"):][:length] for m in modules})
+            if len(prefixes) >= args.regexes:
+                break
+        for r, prefix in enumerate(prefixes[:args.regexes]):
+            addressed.append({"match": f"bench_mod_{prefix}[0-9]*", "data": {"block": r}})
+    if args.catch_all or not addressed:
+        addressed.append({"match": "", "data": {}})
+    commands = {}
+    for cmd in COMMANDS:
+        data = [dict(a) for a in addressed]
+        if cmd == "start":
+            data = [dict(a, data={"run": 1}) for a in addressed]
+        commands[cmd] = {"modules": data}
+    with open(args.output + ".commands.json", "w") as f:
+        json.dump(commands, f, indent=1)
+
+    print(f"Wrote {args.output}.data.xml ({args.modules} modules, {len(steps)} steps per action plan) and "
+          f"{args.output}.commands.json ({len(addressed)} addressed entries per command)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--modules", type=int, default=100, help="number of DummyModules (10 to 10000)")
+    parser.add_argument("--group-by", choices=["id", "type"], default="id",
+                        help="action plan steps group modules by id or by type")
+    parser.add_argument("--steps", type=int, default=1, help="number of action plan steps when grouping by id")
+    parser.add_argument("--policy", choices=["modules-in-parallel", "modules-in-series"],
+                        default="modules-in-parallel", help="action plan execution policy")
+    parser.add_argument("--regexes", type=int, default=1, help="number of addressing regexes in the command data")
+    parser.add_argument("--catch-all", action="store_true", help="add an empty match addressing all modules")
+    parser.add_argument("--include", default="test/config/appSession.data.xml",
+                        help="database providing the FSM commands, hosts and session objects")
+    parser.add_argument("-o", "--output", default="bench", help="output file prefix")
+    args = parser.parse_args()
+
+    if not 1 <= args.modules <= 100000:
+        parser.error("--modules must be between 1 and 100000")
+    generate(args)
+
+
+if __name__ == "__main__":
+    main()
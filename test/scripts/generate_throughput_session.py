@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Generate an OKS session measuring the throughput of IOManager queues inside
+one application: ThroughputProducers send fixed-size payloads as fast as
+possible to queues read by ThroughputConsumers, which publish the message and
+byte rates and the transfer latency percentiles through opmon.
+
+The generated database includes test/config/appSession.data.xml and defines
+the DaqApplication ThroughputApp in the session throughput-session, together
+with a stdin command facility file with the conf/start/stop/scrap commands,
+e.g.:
+
+  generate_throughput_session.py --queues 2 --producers-per-queue 2 --queue-type kFollyMPMCQueue -o tp
+  (echo conf; echo start; sleep 30; echo stop; echo scrap) | \\
+    daq_application -n ThroughputApp -s throughput-session -c stdin://tp.commands.json -d oksconflibs:tp.data.xml
+"""
+
+import argparse
+import json
+
+from generate_benchmark_session import HEADER, obj
+
+QUEUE_TYPES = ["kStdDeQueue", "kFollySPSCQueue", "kFollyMPMCQueue"]
+
+
+def generate(args):
+    cores = iter(args.cores * (2 * args.queues * (args.producers_per_queue + 1)))
+    objects, modules = [], []
+    for q in range(args.queues):
+        queue = f"throughput_queue_{q}"
+        objects.append(obj("Queue", queue,
+                           attrs=[("data_type", "string", "ThroughputPayload"),
+                                  ("queue_type", "enum", args.queue_type),
+                                  ("capacity", "u32", args.capacity)]))
+        for p in range(args.producers_per_queue):
+            uid = f"throughput_producer_{q}_{p}"
+            modules.append(("ThroughputProducer", uid))
+            objects.append(obj("ThroughputProducer", uid,
+                               attrs=[("payload_bytes", "u32", args.payload_bytes),
+                                      ("max_messages", "u64", args.max_messages),
+                                      ("send_timeout_ms", "u32", args.send_timeout_ms),
+                                      ("cpu", "s32", next(cores, -1))],
+                               rels=[("outputs", [("Queue", queue)])]))
+        uid = f"throughput_consumer_{q}"
+        modules.append(("ThroughputConsumer", uid))
+        objects.append(obj("ThroughputConsumer", uid,
+                           attrs=[("cpu", "s32", next(cores, -1))],
+                           rels=[("inputs", [("Queue", queue)])]))
+
+    objects.append(obj("OpMonConf", "throughput-monitoring",
+                       attrs=[("level", "u32", 4294967295), ("interval_s", "u32", args.opmon_interval_s)]))
+    objects.append(obj("DaqApplication", "ThroughputApp",
+                       attrs=[("application_name", "string", "daq_application")],
+                       rels=[("runs_on", ("VirtualHost", "vlocalhost")),
+                             ("opmon_conf", ("OpMonConf", "throughput-monitoring")),
+                             ("modules", modules)]))
+    objects.append(obj("Segment", "throughput-segment",
+                       rels=[("applications", [("DaqApplication", "ThroughputApp")]),
+                             ("controller", ("RCApplication", "my-controller"))]))
+    objects.append(obj("Session", "throughput-session",
+                       attrs=[("data_request_timeout_ms", "u32", 1000),
+                              ("data_rate_slowdown_factor", "u32", 1),
+                              ("controller_log_level", "enum", "INFO")],
+                       rels=[("environment", [("VariableSet", "common-env")]),
+                             ("segment", ("Segment", "throughput-segment")),
+                             ("detector_configuration", ("DetectorConfig", "dummy-detector")),
+                             ("opmon_uri", ("OpMonURI", "local-opmon-uri"))]))
+
+    with open(args.output + ".data.xml", "w") as f:
+        f.write(HEADER.format(items=len(objects), include=args.include))
+        f.write("\n".join(objects))
+        f.write("</oks-data>\n")
+
+    commands = [{"id": "conf", "data": {"modules": [{"match": "", "data": {}}]}},
+                {"id": "start", "data": {"modules": [{"match": "", "data": {"run": 1}}]}},
+                {"id": "stop", "data": {"modules": [{"match": "", "data": {}}]}},
+                {"id": "scrap", "data": {"modules": [{"match": "", "data": {}}]}}]
+    with open(args.output + ".commands.json", "w") as f:
+        json.dump(commands, f, indent=1)
+
+    print(f"Wrote {args.output}.data.xml ({args.queues} {args.queue_type} queues of capacity {args.capacity}, "
+          f"{args.producers_per_queue} producer(s) of {args.payload_bytes} byte payloads per queue) and "
+          f"{args.output}.commands.json")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--queues", type=int, default=1, help="number of queues, each read by one consumer")
+    parser.add_argument("--producers-per-queue", type=int, default=1, help="number of producers writing to each queue")
+    parser.add_argument("--queue-type", choices=QUEUE_TYPES, default="kFollySPSCQueue", help="IOManager queue type")
+    parser.add_argument("--capacity", type=int, default=1000, help="queue capacity")
+    parser.add_argument("--payload-bytes", type=int, default=1024, help="size of the payloads")
+    parser.add_argument("--max-messages", type=int, default=0,
+                        help="payloads sent by each producer in a run, 0 for no limit")
+    parser.add_argument("--send-timeout-ms", type=int, default=10,
+                        help="time a producer waits for space in a full queue before dropping a payload")
+    parser.add_argument("--cores", type=int, nargs="*", default=[],
+                        help="cores the module threads are pinned to, in turn (producers of a queue, then its "
+                             "consumer); threads are not pinned if not given")
+    parser.add_argument("--opmon-interval-s", type=int, default=1, help="opmon reporting interval")
+    parser.add_argument("--include", default="test/config/appSession.data.xml",
+                        help="database providing the FSM commands, hosts and session objects")
+    parser.add_argument("-o", "--output", default="throughput", help="output file prefix")
+    args = parser.parse_args()
+
+    if args.queues < 1 or args.producers_per_queue < 1:
+        parser.error("--queues and --producers-per-queue must be at least 1")
+    if args.producers_per_queue > 1 and args.queue_type == "kFollySPSCQueue":
+        parser.error("several producers per queue need a multi-producer queue type")
+    generate(args)
+
+
+if __name__ == "__main__":
+    main()
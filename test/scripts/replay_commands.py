@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Replay the commands recorded by daq_application --recordCommands against a
+fresh daq_application, through the stdin command facility, and report the
+execution time of every transition in the recording and in the replay. The
+time commands waited in the admission queue is reported separately, as it
+depends on the replay speed.
+
+Example:
+  daq_application -n TestApp -s test-session -c rest://localhost:5000 \\
+      -d oksconflibs:test/config/appSession.data.xml --recordCommands run.jsonl
+  ...
+  replay_commands.py run.jsonl -n TestApp -s test-session \\
+      -d oksconflibs:test/config/appSession.data.xml --speed max --report report.json
+"""
+
+import argparse
+import json
+import os
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def load_recording(path):
+    with open(path) as f:
+        lines = [json.loads(line) for line in f if line.strip()]
+    return sorted(lines, key=lambda l: l["received_ms"])
+
+
+def make_command_file(recording, path):
+    """The stdin facility looks commands up by id, so each id can only have one payload"""
+    commands = {}
+    for line in recording:
+        cmd = line["command"]
+        if cmd["id"] in commands and commands[cmd["id"]] != cmd:
+            print(f"WARNING: command {cmd['id']} was recorded with different payloads, replaying the first one",
+                  file=sys.stderr)
+            continue
+        commands.setdefault(cmd["id"], cmd)
+    with open(path, "w") as f:
+        json.dump(list(commands.values()), f, indent=2)
+
+
+def count_lines(path):
+    if not os.path.exists(path):
+        return 0
+    with open(path) as f:
+        return sum(1 for line in f if line.strip())
+
+
+def replay(args, recording, workdir):
+    command_file = os.path.join(workdir, "commands.json")
+    replay_recording = os.path.join(workdir, "replay.jsonl")
+    make_command_file(recording, command_file)
+
+    cmdline = [args.daq_application, "-n", args.name, "-s", args.session, "-c", f"stdin://{command_file}",
+               "-d", args.conf, "--recordCommands", replay_recording]
+    if args.speed == "max":
+        # Commands are sent without waiting, let the application queue them instead of rejecting them
+        cmdline += ["--commandQueue", str(len(recording))]
+    cmdline += args.extra
+
+    print("Running", " ".join(cmdline))
+    proc = subprocess.Popen(cmdline, stdin=subprocess.PIPE, text=True)
+
+    start = time.monotonic()
+    for line in recording:
+        if args.speed == "original":
+            delay = start + line["received_ms"] / 1000. - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        proc.stdin.write(line["command"]["id"] + "\n")
+        proc.stdin.flush()
+
+    # Every command writes its line once it completed
+    deadline = time.monotonic() + args.timeout
+    while count_lines(replay_recording) < len(recording) and time.monotonic() < deadline:
+        if proc.poll() is not None:
+            break
+        time.sleep(0.1)
+    completed = count_lines(replay_recording)
+    if completed < len(recording):
+        print(f"WARNING: only {completed} of {len(recording)} commands completed", file=sys.stderr)
+
+    if proc.poll() is None:
+        proc.send_signal(signal.SIGINT)
+        proc.stdin.close()
+        try:
+            proc.wait(timeout=30)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+
+    return load_recording(replay_recording) if os.path.exists(replay_recording) else []
+
+
+def summarize(recording):
+    durations = {}
+    for line in recording:
+        durations.setdefault(line["command"]["id"], []).append(line)
+    summary = {}
+    for cmd, lines in durations.items():
+        # duration_ms is the execution time from admission, queued_ms the wait before it
+        values = [l["duration_ms"] for l in lines]
+        queued = [l.get("queued_ms", 0.) for l in lines]
+        summary[cmd] = {
+            "count": len(values),
+            "failures": sum(1 for l in lines if not l["success"]),
+            "median_queued_ms": statistics.median(queued),
+            "mean_ms": statistics.mean(values),
+            "median_ms": statistics.median(values),
+            "min_ms": min(values),
+            "max_ms": max(values),
+        }
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("recording", help="file written by daq_application --recordCommands")
+    parser.add_argument("-n", "--name", required=True, help="application name")
+    parser.add_argument("-s", "--session", required=True, help="session name")
+    parser.add_argument("-d", "--conf", required=True, help="configuration service URI")
+    parser.add_argument("--speed", choices=["original", "max"], default="original",
+                        help="send commands with their recorded inter-arrival times, or as fast as possible")
+    parser.add_argument("--report", help="write the timing report to this JSON file")
+    parser.add_argument("--timeout", type=float, default=600., help="seconds to wait for the commands to complete")
+    parser.add_argument("--daq-application", default="daq_application", help="daq_application executable")
+    # Any other argument is passed on to daq_application
+    args, args.extra = parser.parse_known_args()
+
+    recording = load_recording(args.recording)
+    if not recording:
+        sys.exit(f"No commands in {args.recording}")
+
+    with tempfile.TemporaryDirectory() as workdir:
+        replayed = replay(args, recording, workdir)
+
+    report = {"speed": args.speed, "recorded": summarize(recording), "replayed": summarize(replayed)}
+
+    print(f"{'command':24} {'n':>5} {'recorded ms':>12} {'replayed ms':>12} {'change':>8} {'queued ms':>10}")
+    for cmd, rec in report["recorded"].items():
+        rep = report["replayed"].get(cmd)
+        if rep is None:
+            print(f"{cmd:24} {rec['count']:>5} {rec['median_ms']:>12.3f} {'-':>12} {'-':>8} {'-':>10}")
+            continue
+        change = (rep["median_ms"] / rec["median_ms"] - 1) * 100 if rec["median_ms"] > 0 else 0.
+        print(f"{cmd:24} {rep['count']:>5} {rec['median_ms']:>12.3f} {rep['median_ms']:>12.3f} {change:>7.1f}% "
+              f"{rep['median_queued_ms']:>10.3f}")
+
+    if args.report:
+        with open(args.report, "w") as f:
+            json.dump(report, f, indent=2)
+
+    failed = sum(s["failures"] for s in report["replayed"].values())
+    sys.exit(1 if failed > sum(s["failures"] for s in report["recorded"].values()) else 0)
+
+
+if __name__ == "__main__":
+    main()
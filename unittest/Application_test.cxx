@@ -16,8 +16,15 @@
 
 #include "boost/test/unit_test.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <unistd.h>
 
 BOOST_AUTO_TEST_SUITE(Application_test)
 
@@ -32,6 +39,40 @@ struct EnvFixture
 };
 BOOST_TEST_GLOBAL_FIXTURE(EnvFixture);
 
+nlohmann::json
+make_command(const std::string& id,
+             const std::string& entry_state,
+             const std::string& exit_state,
+             const nlohmann::json& module_data = nlohmann::json::object())
+{
+  dunedaq::appfwk::cmd::AddressedCmd addr_cmd;
+  addr_cmd.match = "";
+  addr_cmd.data = module_data;
+  dunedaq::appfwk::cmd::CmdObj cmd_obj;
+  cmd_obj.modules.push_back(addr_cmd);
+
+  dunedaq::rcif::cmd::RCCommand cmd;
+  cmd.id = id;
+  to_json(cmd.data, cmd_obj);
+  cmd.entry_state = entry_state;
+  cmd.exit_state = exit_state;
+  nlohmann::json cmd_data;
+  to_json(cmd_data, cmd);
+  return cmd_data;
+}
+
+bool
+wait_for(const std::function<bool()>& condition)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
 BOOST_AUTO_TEST_CASE(Constructor)
 {
   Application app(
@@ -238,4 +279,160 @@ BOOST_AUTO_TEST_CASE(State)
   dunedaq::iomanager::IOManager::get()->reset();
 }
 
+BOOST_AUTO_TEST_CASE(FsmTransitions)
+{
+  dunedaq::get_iomanager()->reset();
+  Application app("TestApp", "test-session", "stdin://" + TEST_JSON_FILE, "oksconflibs:" + TEST_OKS_DB);
+
+  dunedaq::rcif::cmd::RCCommand cmd;
+  nlohmann::json cmd_data;
+
+  // States outside of the FSM do not restrict commands without an entry state
+  cmd.id = "start";
+  cmd.entry_state = "ANY";
+  to_json(cmd_data, cmd);
+  BOOST_REQUIRE_EQUAL(app.is_cmd_valid(cmd_data), true);
+
+  // In an FSM state, only the transitions leaving that state are legal, even with entry state ANY
+  app.set_state("configured");
+  BOOST_REQUIRE_EQUAL(app.is_cmd_valid(cmd_data), true);
+  cmd.id = "conf";
+  to_json(cmd_data, cmd);
+  BOOST_REQUIRE_EQUAL(app.is_cmd_valid(cmd_data), false);
+
+  // Commands that are not FSM transitions are legal in any state with entry state ANY
+  cmd.id = "stuff";
+  to_json(cmd_data, cmd);
+  BOOST_REQUIRE_EQUAL(app.is_cmd_valid(cmd_data), true);
+  app.set_state("running");
+  BOOST_REQUIRE_EQUAL(app.is_cmd_valid(cmd_data), true);
+  app.set_state("configured");
+  cmd.id = "conf";
+
+  // An explicit entry state is still honoured
+  cmd.entry_state = "configured";
+  to_json(cmd_data, cmd);
+  BOOST_REQUIRE_EQUAL(app.is_cmd_valid(cmd_data), true);
+  BOOST_REQUIRE_EQUAL(app.get_state(), "configured");
+  dunedaq::iomanager::IOManager::get()->reset();
+}
+
+BOOST_AUTO_TEST_CASE(CommandQueue)
+{
+  dunedaq::get_iomanager()->reset();
+  Application app("TestApp", "test-session", "stdin://" + TEST_JSON_FILE, "oksconflibs:" + TEST_OKS_DB);
+  app.set_command_queue_depth(2);
+  app.init();
+  auto queued = [&app]() { return app.introspect("get_status")["queued_commands"].get<size_t>(); };
+
+  // A slow command, leaving the application in a state of its own
+  std::thread slow([&app]() { app.execute(make_command("slow_stuff", "ANY", "slow_done", { { "wait_ms", 300 } })); });
+  BOOST_REQUIRE(wait_for([&app]() { return app.introspect("get_status")["busy"].get<bool>(); }));
+
+  // Queued behind it: a command valid in any state, then one only valid in the state before the slow command
+  std::atomic<bool> any_state_done{ false };
+  std::thread any_state([&]() {
+    app.execute(make_command("stuff", "ANY", "ANY"));
+    any_state_done = true;
+  });
+  BOOST_REQUIRE(wait_for([&]() { return queued() == 1; }));
+  std::atomic<bool> stale_state_rejected{ false };
+  std::thread stale_state([&]() {
+    try {
+      app.execute(make_command("stuff", "INITIAL", "ANY"));
+    } catch (InvalidCommand&) {
+      stale_state_rejected = true;
+    }
+  });
+  BOOST_REQUIRE(wait_for([&]() { return queued() == 2; }));
+
+  // The queue is full
+  BOOST_REQUIRE_EXCEPTION(
+    app.execute(make_command("stuff", "ANY", "ANY")), InvalidCommand, [&](InvalidCommand) { return true; });
+
+  slow.join();
+  any_state.join();
+  stale_state.join();
+  BOOST_REQUIRE(any_state_done.load());
+  BOOST_REQUIRE(stale_state_rejected.load());
+  BOOST_REQUIRE_EQUAL(queued(), 0);
+  BOOST_REQUIRE_EQUAL(app.get_state(), "slow_done");
+
+  // The history is in order of completion: the rejection of the command beyond capacity, then the queued commands
+  // in order of arrival, each one dequeued (and the stale one rejected) after the previous one ended
+  auto history = app.introspect("get_history");
+  BOOST_REQUIRE_EQUAL(history.size(), 4);
+  BOOST_REQUIRE_EQUAL(history[0]["success"].get<bool>(), false);
+  BOOST_REQUIRE_EQUAL(history[1]["id"].get<std::string>(), "slow_stuff");
+  BOOST_REQUIRE_EQUAL(history[1]["success"].get<bool>(), true);
+  BOOST_REQUIRE_EQUAL(history[2]["id"].get<std::string>(), "stuff");
+  BOOST_REQUIRE_EQUAL(history[2]["entry_state"].get<std::string>(), "ANY");
+  BOOST_REQUIRE_EQUAL(history[2]["success"].get<bool>(), true);
+  BOOST_REQUIRE_GE(history[2]["started_us"].get<int64_t>(), history[1]["ended_us"].get<int64_t>());
+  BOOST_REQUIRE_GT(history[2]["queued_ms"].get<double>(), 0.);
+  BOOST_REQUIRE_EQUAL(history[3]["entry_state"].get<std::string>(), "INITIAL");
+  BOOST_REQUIRE_EQUAL(history[3]["success"].get<bool>(), false);
+  BOOST_REQUIRE_GE(history[3]["started_us"].get<int64_t>(), history[2]["ended_us"].get<int64_t>());
+  BOOST_REQUIRE_GT(history[3]["queued_ms"].get<double>(), 0.);
+  dunedaq::iomanager::IOManager::get()->reset();
+}
+
+BOOST_AUTO_TEST_CASE(IntrospectionReplyPublished)
+{
+  // The opmon URI of the test session is the file ./info.json, one entry per line
+  auto replies = []() {
+    std::ifstream ifs("info.json");
+    size_t count = 0;
+    for (std::string line; std::getline(ifs, line);) {
+      if (line.find("IntrospectionReply") != std::string::npos && line.find("get_status") != std::string::npos)
+        ++count;
+    }
+    return count;
+  };
+  auto before = replies();
+
+  dunedaq::get_iomanager()->reset();
+  Application app("TestApp", "test-session", "stdin://" + TEST_JSON_FILE, "oksconflibs:" + TEST_OKS_DB);
+  app.init();
+  app.execute(make_command("get_status", "ANY", "ANY"));
+  BOOST_REQUIRE(wait_for([&]() { return replies() == before + 1; }));
+  dunedaq::iomanager::IOManager::get()->reset();
+}
+
+BOOST_AUTO_TEST_CASE(CommandDataPrefetched)
+{
+  auto dir = std::filesystem::temp_directory_path() / ("Application_test_" + std::to_string(getpid()));
+  std::filesystem::create_directories(dir);
+  dunedaq::rcif::cmd::StartParams start_params;
+  start_params.run = 1011;
+  nlohmann::json start_param_data;
+  to_json(start_param_data, start_params);
+  std::ofstream(dir / "TestApp_start.json") << make_command("start", "ANY", "ANY", start_param_data)["data"].dump();
+
+  dunedaq::get_iomanager()->reset();
+  Application app("TestApp", "test-session", "stdin://" + TEST_JSON_FILE, "oksconflibs:" + TEST_OKS_DB);
+  app.set_command_data_service("file://" + dir.string());
+  app.init();
+
+  // Once configured the application may be started next, the data of start is prefetched
+  app.execute(make_command("conf", "ANY", "configured"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::filesystem::remove_all(dir);
+
+  // start is sent without data, which is only available from the prefetch
+  dunedaq::rcif::cmd::RCCommand cmd;
+  cmd.id = "start";
+  nlohmann::json cmd_data;
+  to_json(cmd_data, cmd);
+  app.execute(cmd_data);
+  BOOST_REQUIRE_EQUAL(app.get_state(), "ready");
+
+  // Nothing is left to be prefetched for stop
+  cmd.id = "stop";
+  to_json(cmd_data, cmd);
+  app.set_state("trigger_sources_stopped");
+  BOOST_REQUIRE_EXCEPTION(app.execute(cmd_data), BadFile, [&](BadFile) { return true; });
+  dunedaq::iomanager::IOManager::get()->reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
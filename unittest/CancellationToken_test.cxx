@@ -0,0 +1,121 @@
+/**
+ * @file CancellationToken_test.cxx CancellationToken class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/CancellationToken.hpp"
+#include "appfwk/Interruptible.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE CancellationToken_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(CancellationToken_test)
+
+namespace cancellationtokentest {
+class TestInterruptible : public Interruptible
+{
+public:
+  using Interruptible::cancellable_wait_any;
+  using Interruptible::interruptible_wait;
+};
+} // namespace cancellationtokentest
+
+BOOST_AUTO_TEST_CASE(DefaultToken)
+{
+  CancellationToken token;
+  BOOST_REQUIRE(!token.stop_possible());
+  BOOST_REQUIRE(!token.stop_requested());
+  BOOST_REQUIRE_EQUAL(token.reason(), "");
+}
+
+BOOST_AUTO_TEST_CASE(RequestStop)
+{
+  CancellationSource source;
+  auto token = source.token();
+  BOOST_REQUIRE(token.stop_possible());
+  BOOST_REQUIRE(!token.stop_requested());
+
+  BOOST_REQUIRE(source.request_stop("first"));
+  BOOST_REQUIRE(!source.request_stop("second"));
+  BOOST_REQUIRE(source.stop_requested());
+  BOOST_REQUIRE(token.stop_requested());
+  BOOST_REQUIRE_EQUAL(token.reason(), "first");
+}
+
+BOOST_AUTO_TEST_CASE(Callbacks)
+{
+  CancellationSource source;
+  auto token = source.token();
+
+  int called = 0;
+  {
+    CancellationCallback unregistered(token, [&]() { called += 10; });
+  }
+  CancellationCallback callback(token, [&]() { ++called; });
+  BOOST_REQUIRE_EQUAL(called, 0);
+
+  source.request_stop("test");
+  BOOST_REQUIRE_EQUAL(called, 1);
+  source.request_stop("again");
+  BOOST_REQUIRE_EQUAL(called, 1);
+
+  // Registered after the cancellation, runs immediately
+  CancellationCallback late(token, [&]() { ++called; });
+  BOOST_REQUIRE_EQUAL(called, 2);
+}
+
+BOOST_AUTO_TEST_CASE(InterruptibleWait)
+{
+  cancellationtokentest::TestInterruptible ti;
+  CancellationSource source;
+  std::atomic<bool> condition{ false };
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread canceller([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    source.request_stop("test");
+  });
+  auto res = ti.interruptible_wait(std::chrono::seconds(10), condition, source.token());
+  auto waited = std::chrono::steady_clock::now() - start;
+  canceller.join();
+
+  BOOST_REQUIRE_EQUAL(res, false);
+  BOOST_REQUIRE(source.token().stop_requested());
+  BOOST_REQUIRE(waited < std::chrono::seconds(5));
+  TLOG() << "Cancelled after " << std::chrono::duration_cast<std::chrono::milliseconds>(waited).count() << " ms";
+
+  // A cancelled token ends the next waits immediately
+  start = std::chrono::steady_clock::now();
+  ti.interruptible_wait(std::chrono::seconds(10), condition, source.token());
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+BOOST_AUTO_TEST_CASE(WaitAny)
+{
+  cancellationtokentest::TestInterruptible ti;
+  CancellationSource source;
+  std::atomic<bool> condition{ false };
+  auto deadline = []() { return std::chrono::steady_clock::now() + std::chrono::milliseconds(10); };
+
+  BOOST_REQUIRE(!ti.cancellable_wait_any(source.token(), deadline(), condition).has_value());
+  condition = true;
+  BOOST_REQUIRE_EQUAL(ti.cancellable_wait_any(source.token(), deadline(), condition).value(), 1);
+  source.request_stop("test");
+  BOOST_REQUIRE_EQUAL(ti.cancellable_wait_any(source.token(), deadline(), condition).value(), 0);
+  BOOST_REQUIRE(!ti.cancellable_wait_any(CancellationToken(), deadline(), [] { return false; }).has_value());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,120 @@
+/**
+ * @file CommandHistory_test.cxx CommandHistory class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "CommandHistory.hpp"
+
+#define BOOST_TEST_MODULE CommandHistory_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(CommandHistory_test)
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+  CommandHistory history(4);
+  BOOST_REQUIRE_EQUAL(history.capacity(), 4);
+  BOOST_REQUIRE_EQUAL(history.records().size(), 0);
+  BOOST_REQUIRE(history.to_json().is_array());
+}
+
+BOOST_AUTO_TEST_CASE(Wraparound)
+{
+  CommandHistory history(4);
+  for (int i = 0; i < 10; ++i) {
+    CommandRecord record;
+    record.id = "cmd" + std::to_string(i);
+    record.success = true;
+    history.record(record);
+  }
+
+  auto records = history.records();
+  BOOST_REQUIRE_EQUAL(records.size(), 4);
+  for (size_t i = 0; i < records.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(records[i]->sequence, 6 + i);
+    BOOST_REQUIRE_EQUAL(records[i]->id, "cmd" + std::to_string(6 + i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RecordContents)
+{
+  CommandHistory history(4);
+  CommandRecord record;
+  record.id = "conf";
+  record.entry_state = "INITIAL";
+  record.exit_state = "CONFIGURED";
+  record.received = std::chrono::system_clock::now();
+  record.started = record.received + std::chrono::milliseconds(5);
+  record.ended = record.started + std::chrono::milliseconds(20);
+  record.success = false;
+  record.error = "failure";
+  record.module_durations_ms["mod_a"] = 12.5;
+  record.failed_modules.push_back("mod_b");
+  history.record(record);
+
+  auto j = history.to_json();
+  BOOST_REQUIRE_EQUAL(j.size(), 1);
+  BOOST_REQUIRE_EQUAL(j[0]["id"].get<std::string>(), "conf");
+  BOOST_REQUIRE_EQUAL(j[0]["exit_state"].get<std::string>(), "CONFIGURED");
+  BOOST_REQUIRE_CLOSE(j[0]["queued_ms"].get<double>(), 5., 1e-6);
+  BOOST_REQUIRE_CLOSE(j[0]["duration_ms"].get<double>(), 20., 1e-6);
+  BOOST_REQUIRE_EQUAL(j[0]["success"].get<bool>(), false);
+  BOOST_REQUIRE_EQUAL(j[0]["error"].get<std::string>(), "failure");
+  BOOST_REQUIRE_CLOSE(j[0]["module_durations_ms"]["mod_a"].get<double>(), 12.5, 1e-6);
+  BOOST_REQUIRE_EQUAL(j[0]["failed_modules"][0].get<std::string>(), "mod_b");
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentRecording)
+{
+  CommandHistory history(16);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 1000; ++i) {
+        CommandRecord record;
+        record.id = "cmd";
+        history.record(record);
+        history.records();
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  auto records = history.records();
+  BOOST_REQUIRE_EQUAL(records.size(), 16);
+  BOOST_REQUIRE_EQUAL(records.back()->sequence, 3999);
+}
+
+BOOST_AUTO_TEST_CASE(Dump)
+{
+  CommandHistory history(4);
+  CommandRecord record;
+  record.id = "start";
+  history.record(record);
+
+  std::string path = "/tmp/CommandHistory_test_" + std::to_string(getpid()) + ".json";
+  BOOST_REQUIRE(history.dump(path));
+  std::ifstream ifs(path);
+  auto j = nlohmann::json::parse(ifs);
+  BOOST_REQUIRE_EQUAL(j.size(), 1);
+  BOOST_REQUIRE_EQUAL(j[0]["id"].get<std::string>(), "start");
+  std::remove(path.c_str());
+
+  BOOST_REQUIRE(!history.dump("/nonexistent/directory/history.json"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -114,6 +114,44 @@ BOOST_AUTO_TEST_CASE(ParseSession)
 
   delete[] arg_list; // NOLINT
 }
+BOOST_AUTO_TEST_CASE(ParseWarmRestart)
+{
+  char** arg_list = new char* [10] {
+    (char*)("CommandLineInterpreter_test"),   // NOLINT
+      (char*)("-c"), (char*)("stdin://"),     // NOLINT
+      (char*)("-d"), (char*)("file://"),      // NOLINT
+      (char*)("-n"), (char*)("cli_test"),     // NOLINT
+      (char*)("-s"), (char*)("test_session"), // NOLINT
+      (char*)("--warmRestart")                // NOLINT
+  };
+  auto parsed = CommandLineInterpreter::parse(10, arg_list);
+
+  BOOST_REQUIRE_EQUAL(parsed.help_requested, false);
+  BOOST_REQUIRE_EQUAL(parsed.warm_restart, true);
+  BOOST_REQUIRE_EQUAL(parsed.other_options.size(), 0);
+
+  delete[] arg_list; // NOLINT
+}
+
+BOOST_AUTO_TEST_CASE(ParseCommandQueue)
+{
+  char** arg_list = new char* [11] {
+    (char*)("CommandLineInterpreter_test"),   // NOLINT
+      (char*)("-c"), (char*)("stdin://"),     // NOLINT
+      (char*)("-d"), (char*)("file://"),      // NOLINT
+      (char*)("-n"), (char*)("cli_test"),     // NOLINT
+      (char*)("-s"), (char*)("test_session"), // NOLINT
+      (char*)("-q"), (char*)("4")             // NOLINT
+  };
+  auto parsed = CommandLineInterpreter::parse(11, arg_list);
+
+  BOOST_REQUIRE_EQUAL(parsed.help_requested, false);
+  BOOST_REQUIRE_EQUAL(parsed.command_queue_depth, 4);
+  BOOST_REQUIRE_EQUAL(parsed.other_options.size(), 0);
+
+  delete[] arg_list; // NOLINT
+}
+
 BOOST_AUTO_TEST_CASE(ParseOtherOption)
 {
   char** arg_list = new char* [10] {
@@ -15,11 +15,24 @@
 
 #include "iomanager/IOManager.hpp"
 
+#include "../test/plugins/ThroughputPayload.hpp"
+
 #define BOOST_TEST_MODULE DAQModuleManager_test // NOLINT
 
 #include "boost/test/unit_test.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <regex>
 #include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
 #include <type_traits>
 
 BOOST_AUTO_TEST_SUITE(DAQModuleManager_test)
@@ -33,14 +46,19 @@ struct EnvFixture
 BOOST_TEST_GLOBAL_FIXTURE(EnvFixture);
 
 std::shared_ptr<dunedaq::appfwk::ConfigurationManager>
-make_config_mgr()
+make_config_mgr_for(std::string appName)
 {
   std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
-  std::string appName = "TestApp";
   std::string sessionName = "test-session";
   return std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName);
 }
 
+std::shared_ptr<dunedaq::appfwk::ConfigurationManager>
+make_config_mgr()
+{
+  return make_config_mgr_for("TestApp");
+}
+
 BOOST_AUTO_TEST_CASE(Construct)
 {
   auto mgr = DAQModuleManager();
@@ -216,4 +234,572 @@ BOOST_AUTO_TEST_CASE(CommandMatchingModules)
                           [&](ConflictingCommandMatching) { return true; });
 }
 
+BOOST_AUTO_TEST_CASE(MalformedCommandDataRejected)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  // No data, or no modules, is not an error
+  mgr.execute("stuff", nlohmann::json());
+  mgr.execute("stuff", nlohmann::json::object());
+
+  for (const auto& malformed : { nlohmann::json(""),
+                                 nlohmann::json::array(),
+                                 nlohmann::json{ { "modules", "dummy_module_0" } },
+                                 nlohmann::json{ { "modules", { 1 } } },
+                                 nlohmann::json{ { "modules", { { { "data", nlohmann::json::object() } } } } },
+                                 nlohmann::json{ { "modules", { { { "match", 3 } } } } },
+                                 nlohmann::json{ { "modules", { { { "match", "dummy(" } } } } } }) {
+    BOOST_TEST_MESSAGE("Command data " << malformed.dump());
+    BOOST_REQUIRE_EXCEPTION(
+      mgr.execute("stuff", malformed), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  }
+  BOOST_REQUIRE_EXCEPTION(mgr.execute("stuff", nlohmann::json("")),
+                          MalformedCommandData,
+                          [&](MalformedCommandData) { return true; });
+}
+
+BOOST_AUTO_TEST_CASE(ReconfigureUnchanged)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+
+  nlohmann::json cmd_data;
+  BOOST_REQUIRE_EXCEPTION(mgr.reconfigure(make_config_mgr(), cmd_data),
+                          DAQModuleManagerNotInitialized,
+                          [&](DAQModuleManagerNotInitialized) { return true; });
+
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  auto changed = mgr.reconfigure(make_config_mgr(), cmd_data);
+  BOOST_REQUIRE_EQUAL(changed.size(), 0);
+
+  mgr.execute("stuff", cmd_data);
+}
+
+BOOST_AUTO_TEST_CASE(ReconfigureModuleSetChanged)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
+  std::string appName = "TestApp_ById";
+  std::string sessionName = "test-session";
+  auto cfgMgr = std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName);
+
+  nlohmann::json cmd_data;
+  BOOST_REQUIRE_EXCEPTION(mgr.reconfigure(cfgMgr, cmd_data),
+                          IncrementalReconfigurationNotPossible,
+                          [&](IncrementalReconfigurationNotPossible) { return true; });
+
+  // The current configuration is still in use
+  mgr.execute("stuff", cmd_data);
+}
+
+namespace {
+
+// Copy of the test configuration with some text of the modules file replaced, removed when it goes out of scope
+struct ModifiedConfiguration
+{
+  ModifiedConfiguration(const std::string& name, const std::vector<std::pair<std::string, std::string>>& replacements)
+    : modules_file("test/config/" + name + "_" + std::to_string(getpid()) + "_appfwk.data.xml")
+    , session_file("test/config/" + name + "_" + std::to_string(getpid()) + ".data.xml")
+  {
+    copy_replacing("test/config/appfwk.data.xml", modules_file, replacements);
+    copy_replacing("test/config/appSession.data.xml",
+                   session_file,
+                   { { R"(<file path="test/config/appfwk.data.xml"/>)", "<file path=\"" + modules_file + "\"/>" } });
+  }
+
+  ~ModifiedConfiguration()
+  {
+    std::remove(modules_file.c_str());
+    std::remove(session_file.c_str());
+  }
+
+  std::shared_ptr<ConfigurationManager> make_config_mgr(std::string app_name) const
+  {
+    std::string oksConfig = "oksconflibs:" + session_file;
+    std::string sessionName = "test-session";
+    return std::make_shared<ConfigurationManager>(oksConfig, app_name, sessionName);
+  }
+
+  static void copy_replacing(const std::string& from,
+                             const std::string& to,
+                             const std::vector<std::pair<std::string, std::string>>& replacements)
+  {
+    std::ifstream ifs(from);
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    for (const auto& [old_text, new_text] : replacements) {
+      auto pos = content.find(old_text);
+      BOOST_REQUIRE(pos != std::string::npos);
+      content.replace(pos, old_text.size(), new_text);
+    }
+    std::ofstream(to) << content;
+  }
+
+  std::string modules_file;
+  std::string session_file;
+};
+
+// Commands run on each module during the reconf command of a trace file, which is removed
+std::map<std::string, std::vector<std::string>>
+reconf_steps(const std::string& trace_path)
+{
+  std::ifstream ifs(trace_path);
+  auto trace = nlohmann::json::parse(ifs);
+  std::remove(trace_path.c_str());
+
+  double reconf_begin = -1, reconf_end = -1;
+  for (const auto& event : trace) {
+    if (event["ph"] == "X" && event["cat"] == "command" && event["name"] == "reconf") {
+      reconf_begin = event["ts"].get<double>();
+      reconf_end = reconf_begin + event["dur"].get<double>();
+    }
+  }
+  BOOST_REQUIRE_GE(reconf_begin, 0);
+  std::map<std::string, std::vector<std::string>> steps_by_module;
+  for (const auto& event : trace) {
+    if (event["ph"] == "X" && event["cat"] == "module" && event["ts"].get<double>() >= reconf_begin &&
+        event["ts"].get<double>() <= reconf_end) {
+      BOOST_REQUIRE(!event["args"].value("failed", false));
+      steps_by_module[event["name"].get<std::string>()].push_back(event["args"]["command"].get<std::string>());
+    }
+  }
+  return steps_by_module;
+}
+
+const std::string s_producer_payload = R"(<attr name="payload_bytes" type="u32" val="1024"/>)";
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ReconfigureChangedModule)
+{
+  // Only the payload size of the producer differs
+  ModifiedConfiguration modified("reconf",
+                                 { { s_producer_payload, R"(<attr name="payload_bytes" type="u32" val="2048"/>)" } });
+
+  std::string trace_path = "/tmp/DAQModuleManager_test_reconf_" + std::to_string(getpid()) + ".json";
+  std::string sessionName = "test-session";
+  std::string appName = "ThroughputApp";
+  std::vector<std::string> changed;
+  {
+    dunedaq::get_iomanager()->reset();
+    auto mgr = DAQModuleManager();
+    mgr.set_trace_file(trace_path, "DAQModuleManager_test");
+
+    std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
+    dunedaq::opmonlib::TestOpMonManager opmgr;
+    mgr.initialize(std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName), opmgr);
+    nlohmann::json cmd_data;
+    mgr.execute("conf", cmd_data);
+
+    changed = mgr.reconfigure(modified.make_config_mgr(appName), cmd_data);
+
+    // The reconfigured producer still feeds the untouched consumer
+    mgr.execute("start", cmd_data);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    mgr.execute("stop", cmd_data);
+    mgr.execute("scrap", cmd_data);
+  }
+  dunedaq::get_iomanager()->reset();
+
+  BOOST_REQUIRE_EQUAL(changed.size(), 1);
+  BOOST_REQUIRE_EQUAL(changed[0], "throughput_producer_0");
+
+  auto steps_by_module = reconf_steps(trace_path);
+  BOOST_REQUIRE_EQUAL(steps_by_module.size(), 1);
+  std::vector<std::string> expected{ "scrap", "init", "conf" };
+  BOOST_REQUIRE(steps_by_module["throughput_producer_0"] == expected);
+}
+
+BOOST_AUTO_TEST_CASE(ReconfigureReferencedObject)
+{
+  // The parameters of a LoadGeneratorModule are in the LoadAction objects it references. Scrap does not fail in
+  // either configuration, only the duration of conf differs.
+  std::pair<std::string, std::string> scrap_succeeds{ R"(<attr name="failure_probability" type="double" val="1"/>)",
+                                                      R"(<attr name="failure_probability" type="double" val="0"/>)" };
+  ModifiedConfiguration current("reconf_current", { scrap_succeeds });
+  ModifiedConfiguration modified(
+    "reconf_modified",
+    { scrap_succeeds,
+      { R"(<attr name="mean_ms" type="double" val="5"/>)", R"(<attr name="mean_ms" type="double" val="6"/>)" } });
+
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(current.make_config_mgr("LoadGeneratorApp"), opmgr);
+  nlohmann::json cmd_data;
+  mgr.execute("conf", cmd_data);
+
+  BOOST_REQUIRE_EQUAL(mgr.reconfigure(current.make_config_mgr("LoadGeneratorApp"), cmd_data).size(), 0);
+  auto changed = mgr.reconfigure(modified.make_config_mgr("LoadGeneratorApp"), cmd_data);
+  BOOST_REQUIRE_EQUAL(changed.size(), 1);
+  BOOST_REQUIRE_EQUAL(changed[0], "load_generator_0");
+  mgr.execute("scrap", cmd_data);
+  dunedaq::get_iomanager()->reset();
+}
+
+BOOST_AUTO_TEST_CASE(ReconfigureRunning)
+{
+  ModifiedConfiguration modified("reconf_running",
+                                 { { s_producer_payload, R"(<attr name="payload_bytes" type="u32" val="2048"/>)" } });
+
+  std::string trace_path = "/tmp/DAQModuleManager_test_reconf_running_" + std::to_string(getpid()) + ".json";
+  std::string appName = "ThroughputApp";
+  uint64_t sent_before = 0, sent_after = 0;
+  {
+    dunedaq::get_iomanager()->reset();
+    auto mgr = DAQModuleManager();
+    mgr.set_trace_file(trace_path, "DAQModuleManager_test");
+    dunedaq::opmonlib::TestOpMonManager opmgr;
+    auto sent_messages = [&]() -> uint64_t {
+      opmgr.collect();
+      auto entries = opmgr.get_backend_facility()->get_entries(std::regex(".*throughput_producer_0"),
+                                                               std::regex(".*ThroughputProducerInfo"));
+      return entries.empty() ? 0 : entries.back().data().at("sent_messages").uint8_value();
+    };
+
+    mgr.initialize(make_config_mgr_for(appName), opmgr);
+    nlohmann::json cmd_data;
+    mgr.execute("conf", cmd_data);
+    mgr.execute("start", cmd_data);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto changed = mgr.reconfigure(modified.make_config_mgr(appName), cmd_data);
+    BOOST_REQUIRE_EQUAL(changed.size(), 1);
+
+    // The producer was started again and keeps sending
+    sent_before = sent_messages();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sent_after = sent_messages();
+    mgr.execute("stop", cmd_data);
+    mgr.execute("scrap", cmd_data);
+  }
+  dunedaq::get_iomanager()->reset();
+  BOOST_REQUIRE_GT(sent_after, sent_before);
+
+  auto steps_by_module = reconf_steps(trace_path);
+  BOOST_REQUIRE_EQUAL(steps_by_module.size(), 1);
+  std::vector<std::string> expected{ "stop", "scrap", "init", "conf", "start" };
+  BOOST_REQUIRE(steps_by_module["throughput_producer_0"] == expected);
+}
+
+BOOST_AUTO_TEST_CASE(ReconfigureInvalidActionPlan)
+{
+  // TestApp also gets the action plan of a command its modules do not have
+  std::string test_app_plans = "  <ref class=\"ActionPlan\" id=\"stuff\"/>\n"
+                               "  <ref class=\"ActionPlan\" id=\"bad_stuff\"/>";
+  ModifiedConfiguration modified(
+    "reconf_invalid", { { test_app_plans, test_app_plans + "\n  <ref class=\"ActionPlan\" id=\"bad_action\"/>" } });
+
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  nlohmann::json cmd_data;
+  BOOST_REQUIRE_EXCEPTION(mgr.reconfigure(modified.make_config_mgr("TestApp"), cmd_data),
+                          ActionPlanValidationFailed,
+                          [&](ActionPlanValidationFailed) { return true; });
+
+  // The current configuration, without an action plan for bad_action, is still in use: no module has the command
+  mgr.execute("bad_action", cmd_data);
+  mgr.execute("stuff", cmd_data);
+}
+
+BOOST_AUTO_TEST_CASE(CommandProgress)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  BOOST_REQUIRE(mgr.get_progress() == nullptr);
+
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  nlohmann::json cmd_data;
+  mgr.execute("stuff", cmd_data);
+
+  auto progress = mgr.get_progress();
+  BOOST_REQUIRE(progress != nullptr);
+  BOOST_REQUIRE_EQUAL(progress->command, "stuff");
+  BOOST_REQUIRE_NE(progress->end_ns.load(), 0);
+  BOOST_REQUIRE(!progress->modules.empty());
+  for (const auto& [name, module] : progress->modules) {
+    BOOST_REQUIRE_NE(module.end_ns.load(), 0);
+    BOOST_REQUIRE_EQUAL(module.failed.load(), false);
+  }
+
+  auto progress_json = progress->to_json();
+  BOOST_REQUIRE_EQUAL(progress_json["running"].get<bool>(), false);
+  BOOST_REQUIRE_EQUAL(progress_json["in_flight"].size(), 0);
+
+  BOOST_REQUIRE_EXCEPTION(
+    mgr.execute("bad_stuff", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  bool any_failed = false;
+  for (const auto& [name, module] : mgr.get_progress()->modules)
+    any_failed = any_failed || module.failed.load();
+  BOOST_REQUIRE(any_failed);
+}
+
+BOOST_AUTO_TEST_CASE(TraceFile)
+{
+  std::string path = "/tmp/DAQModuleManager_test_trace_" + std::to_string(getpid()) + ".json";
+  {
+    dunedaq::get_iomanager()->reset();
+    auto mgr = DAQModuleManager();
+    mgr.set_trace_file(path, "DAQModuleManager_test");
+
+    dunedaq::opmonlib::TestOpMonManager opmgr;
+    mgr.initialize(make_config_mgr(), opmgr);
+    nlohmann::json cmd_data;
+    mgr.execute("stuff", cmd_data);
+    BOOST_REQUIRE_EXCEPTION(
+      mgr.execute("bad_stuff", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  }
+
+  std::ifstream ifs(path);
+  auto trace = nlohmann::json::parse(ifs);
+  std::remove(path.c_str());
+
+  std::map<std::string, std::vector<nlohmann::json>> events_by_category;
+  for (const auto& event : trace) {
+    if (event["ph"] == "X")
+      events_by_category[event["cat"].get<std::string>()].push_back(event);
+  }
+  BOOST_REQUIRE_EQUAL(events_by_category["command"].size(), 3); // init, stuff, bad_stuff
+  BOOST_REQUIRE_EQUAL(events_by_category["command"][1]["name"].get<std::string>(), "stuff");
+  BOOST_REQUIRE(events_by_category["command"][2]["args"]["failed"].get<bool>());
+  BOOST_REQUIRE_EQUAL(events_by_category["step"].size(), 2);
+  BOOST_REQUIRE_EQUAL(events_by_category["step"][0]["name"].get<std::string>(), "dummymodules_type_group");
+  BOOST_REQUIRE(!events_by_category["module"].empty());
+  for (const auto& event : events_by_category["module"]) {
+    BOOST_REQUIRE(event["args"].contains("command"));
+    BOOST_REQUIRE(event["args"].contains("success"));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CommandTimeout)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  mgr.set_command_timeout(std::chrono::milliseconds(100));
+
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  // Modules which do not use the token are not affected
+  nlohmann::json cmd_data;
+  mgr.execute("stuff", cmd_data);
+
+  auto start = std::chrono::steady_clock::now();
+  BOOST_REQUIRE_EXCEPTION(
+    mgr.execute("slow_stuff", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+  BOOST_REQUIRE(!mgr.abort("no command running"));
+}
+
+BOOST_AUTO_TEST_CASE(AbortCommand)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  mgr.initialize(make_config_mgr(), opmgr);
+
+  std::atomic<bool> aborted{ false };
+  std::thread aborter([&]() {
+    while (!aborted.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      aborted = mgr.abort("test");
+    }
+  });
+  auto start = std::chrono::steady_clock::now();
+  nlohmann::json cmd_data;
+  BOOST_REQUIRE_EXCEPTION(
+    mgr.execute("slow_stuff", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  aborter.join();
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+  // The next command gets a new token
+  cmd_data["modules"] = nlohmann::json::array({ { { "match", "" }, { "data", { { "wait_ms", 1 } } } } });
+  mgr.execute("slow_stuff", cmd_data);
+}
+
+BOOST_AUTO_TEST_CASE(FailFast)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  mgr.set_fail_fast(true);
+
+  std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
+  std::string appName = "TestApp_ById";
+  std::string sessionName = "test-session";
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  auto cfgMgr = std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName);
+  mgr.initialize(cfgMgr, opmgr);
+
+  // Both modules run slow_stuff in parallel: the first one fails at once, the second one would wait for 10 s
+  nlohmann::json cmd_data;
+  nlohmann::json failing = { { "match", "dummy_module_0" }, { "data", { { "fail", true } } } };
+  nlohmann::json waiting = { { "match", "dummy_module_1" }, { "data", nlohmann::json::object() } };
+  cmd_data["modules"] = nlohmann::json::array({ failing, waiting });
+  auto start = std::chrono::steady_clock::now();
+  BOOST_REQUIRE_EXCEPTION(
+    mgr.execute("slow_stuff", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+  // The second module returned early because the failure of the first one cancelled the command
+  auto progress = mgr.get_progress();
+  BOOST_REQUIRE(progress->modules.at("dummy_module_0").failed.load());
+  BOOST_REQUIRE(progress->modules.at("dummy_module_1").failed.load());
+  BOOST_REQUIRE_GE(progress->modules.at("dummy_module_1").end_ns.load(),
+                   progress->modules.at("dummy_module_0").end_ns.load());
+
+  // Without fail fast, a failure does not cut the other modules short
+  mgr.set_fail_fast(false);
+  cmd_data["modules"][1]["data"]["wait_ms"] = 300;
+  start = std::chrono::steady_clock::now();
+  BOOST_REQUIRE_EXCEPTION(
+    mgr.execute("slow_stuff", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(300));
+  BOOST_REQUIRE(!mgr.get_progress()->modules.at("dummy_module_1").failed.load());
+}
+
+BOOST_AUTO_TEST_CASE(LoadGenerator)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+
+  std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
+  std::string appName = "LoadGeneratorApp";
+  std::string sessionName = "test-session";
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  auto cfgMgr = std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName);
+  mgr.initialize(cfgMgr, opmgr);
+
+  nlohmann::json cmd_data;
+  mgr.execute("conf", cmd_data);
+  // conf sleeps between 3 and 7 ms
+  auto elapsed_ms = mgr.get_progress()->to_json()["modules"]["load_generator_0"]["elapsed_ms"].get<double>();
+  BOOST_REQUIRE_GE(elapsed_ms, 3.);
+
+  // start writes a file and removes it
+  mgr.execute("start", cmd_data);
+  std::ifstream load_file("/tmp/load_generator_0_start_" + std::to_string(getpid()) + ".load");
+  BOOST_REQUIRE(!load_file.is_open());
+  mgr.execute("stop", cmd_data);
+
+  // scrap fails with probability 1
+  BOOST_REQUIRE_EXCEPTION(
+    mgr.execute("scrap", cmd_data), CommandDispatchingFailed, [&](CommandDispatchingFailed) { return true; });
+}
+
+BOOST_AUTO_TEST_CASE(Throughput)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+
+  std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
+  std::string appName = "ThroughputApp";
+  std::string sessionName = "test-session";
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  auto cfgMgr = std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName);
+  mgr.initialize(cfgMgr, opmgr);
+
+  nlohmann::json cmd_data;
+  mgr.execute("conf", cmd_data);
+  mgr.execute("start", cmd_data);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  mgr.execute("stop", cmd_data);
+
+  // Payloads went through the queue. Both modules stop in parallel, so the consumer may have drained the queue
+  // before the producer sent its last payloads, at most a full queue of them.
+  opmgr.collect();
+  auto backend = opmgr.get_backend_facility();
+  auto producer = backend->get_entries(std::regex(".*throughput_producer_0"), std::regex(".*ThroughputProducerInfo"));
+  auto consumer = backend->get_entries(std::regex(".*throughput_consumer_0"), std::regex(".*ThroughputConsumerInfo"));
+  BOOST_REQUIRE(!producer.empty());
+  BOOST_REQUIRE(!consumer.empty());
+  auto sent = producer.back().data().at("sent_messages").uint8_value();
+  auto received = consumer.back().data().at("received_messages").uint8_value();
+  BOOST_TEST_MESSAGE("sent " << sent << ", received " << received);
+  BOOST_REQUIRE_GT(sent, 0);
+  BOOST_REQUIRE_GT(received, 0);
+  BOOST_REQUIRE_LE(received, sent);
+  BOOST_REQUIRE_LE(sent - received, 1000); // capacity of throughput_queue_0
+  BOOST_REQUIRE_EQUAL(producer.back().data().at("sent_bytes").uint8_value(), sent * 1024);
+  BOOST_REQUIRE_EQUAL(consumer.back().data().at("received_bytes").uint8_value(), received * 1024);
+
+  mgr.execute("scrap", cmd_data);
+  auto progress = mgr.get_progress()->to_json();
+  BOOST_REQUIRE(progress["modules"].contains("throughput_producer_0"));
+  BOOST_REQUIRE(progress["modules"].contains("throughput_consumer_0"));
+  dunedaq::get_iomanager()->reset();
+}
+
+BOOST_AUTO_TEST_CASE(WarmRestart)
+{
+  dunedaq::get_iomanager()->reset();
+  auto mgr = DAQModuleManager();
+  mgr.set_warm_restart(true);
+
+  std::string oksConfig = "oksconflibs:test/config/appSession.data.xml";
+  std::string appName = "ThroughputApp";
+  std::string sessionName = "test-session";
+  dunedaq::opmonlib::TestOpMonManager opmgr;
+  auto cfgMgr = std::make_shared<dunedaq::appfwk::ConfigurationManager>(oksConfig, appName, sessionName);
+
+  // The producer counts the payloads it sent since it was constructed, and the consumer those it received
+  auto sent_messages = [&]() -> uint64_t {
+    opmgr.collect();
+    auto entries = opmgr.get_backend_facility()->get_entries(std::regex(".*throughput_producer_0"),
+                                                             std::regex(".*ThroughputProducerInfo"));
+    return entries.empty() ? 0 : entries.back().data().at("sent_messages").uint8_value();
+  };
+  auto received_messages = [&]() -> uint64_t {
+    opmgr.collect();
+    auto entries = opmgr.get_backend_facility()->get_entries(std::regex(".*throughput_consumer_0"),
+                                                             std::regex(".*ThroughputConsumerInfo"));
+    return entries.empty() ? 0 : entries.back().data().at("received_messages").uint8_value();
+  };
+  nlohmann::json cmd_data;
+  auto run = [&]() {
+    for (auto cmd : { "conf", "start" })
+      mgr.execute(cmd, cmd_data);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (auto cmd : { "stop", "scrap" })
+      mgr.execute(cmd, cmd_data);
+  };
+
+  mgr.initialize(cfgMgr, opmgr);
+  auto sender = dunedaq::get_iomanager()->get_sender<ThroughputPayload>("throughput_queue_0");
+  run();
+  auto first_run = sent_messages();
+  auto first_run_received = received_messages();
+  BOOST_REQUIRE_GT(first_run, 0);
+  mgr.cleanup();
+
+  // The same module instances and queues are initialised again, with their threads stopped. The consumer registers
+  // its thread again in init.
+  mgr.initialize(cfgMgr, opmgr);
+  BOOST_REQUIRE(dunedaq::get_iomanager()->get_sender<ThroughputPayload>("throughput_queue_0") == sender);
+  BOOST_REQUIRE_EQUAL(sent_messages(), first_run);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  BOOST_REQUIRE_EQUAL(sent_messages(), first_run);
+
+  // and their threads start again with the next run
+  run();
+  BOOST_REQUIRE_GT(sent_messages(), first_run);
+  BOOST_REQUIRE_GT(received_messages(), first_run_received);
+  mgr.cleanup();
+  dunedaq::get_iomanager()->reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -14,8 +14,12 @@
 
 #include "boost/test/unit_test.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <optional>
 #include <thread>
+#include <vector>
 
 constexpr auto queue_timeout = std::chrono::milliseconds(10);
 using namespace dunedaq::appfwk;
@@ -32,6 +36,7 @@ public:
   }
 
   void set_end_wait_condition() { m_wait_condition = true; }
+  void set_spin(std::chrono::nanoseconds spin) { set_wait_spin(spin); }
 
   void interrupt() override
   {
@@ -48,6 +53,29 @@ public:
     return res;
   }
 
+  bool wait_forever() { return interruptible_wait(std::chrono::microseconds::max(), m_wait_condition); }
+
+  std::optional<size_t> wait_any_forever()
+  {
+    return interruptible_wait_any_for(std::chrono::microseconds::max(), m_wait_condition);
+  }
+
+  bool wait_until_proc(std::chrono::steady_clock::time_point deadline)
+  {
+    return interruptible_wait_until(deadline, m_wait_condition);
+  }
+
+  template<typename... Conditions>
+  std::optional<size_t> wait_any_proc(int sleep_time_ms, Conditions&&... conditions)
+  {
+    auto start_time = std::chrono::steady_clock::now();
+    auto res = interruptible_wait_any(start_time + std::chrono::milliseconds(sleep_time_ms),
+                                      std::forward<Conditions>(conditions)...);
+    m_wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+
+    return res;
+  }
+
   std::chrono::milliseconds m_wait_time;
   std::atomic<bool> m_wait_condition;
 };
@@ -99,4 +127,151 @@ BOOST_AUTO_TEST_CASE(Interrupt)
   TLOG() << "Wait time was " << ti.m_wait_time.count() << " ms";
 }
 
+BOOST_AUTO_TEST_CASE(UnboundedWait)
+{
+  // The deadline of the longest waits saturates instead of overflowing into the past
+  interruptibletest::TestInterruptible ti;
+  std::atomic<bool> returned{ false };
+  bool result = false;
+  auto wait_thread = std::thread([&]() {
+    result = ti.wait_forever();
+    returned = true;
+  });
+  usleep(5000);
+  BOOST_REQUIRE(!returned.load());
+  ti.interrupt();
+  wait_thread.join();
+  BOOST_REQUIRE(result);
+
+  ti.m_wait_condition = false;
+  returned = false;
+  std::optional<size_t> which;
+  wait_thread = std::thread([&]() {
+    which = ti.wait_any_forever();
+    returned = true;
+  });
+  usleep(5000);
+  BOOST_REQUIRE(!returned.load());
+  ti.interrupt();
+  wait_thread.join();
+  BOOST_REQUIRE(which == 0);
+}
+
+BOOST_AUTO_TEST_CASE(SpinFullWait)
+{
+  interruptibletest::TestInterruptible ti;
+  ti.set_spin(std::chrono::milliseconds(2));
+  auto res = ti.wait_proc(10);
+
+  BOOST_REQUIRE_EQUAL(res, false);
+  BOOST_REQUIRE(ti.m_wait_time >= std::chrono::milliseconds(10));
+  TLOG() << "Wait time was " << ti.m_wait_time.count() << " ms";
+}
+
+BOOST_AUTO_TEST_CASE(SpinInterrupt)
+{
+  interruptibletest::TestInterruptible ti;
+  ti.set_spin(std::chrono::milliseconds(20));
+  auto wait_thread = std::thread([&]() { ti.wait_proc(100); });
+  usleep(5000);
+  ti.interrupt();
+  wait_thread.join();
+  BOOST_REQUIRE(ti.m_wait_time < std::chrono::milliseconds(100));
+  TLOG() << "Wait time was " << ti.m_wait_time.count() << " ms";
+}
+
+BOOST_AUTO_TEST_CASE(InterruptWithoutWaiters)
+{
+  interruptibletest::TestInterruptible ti;
+  for (int i = 0; i < 1000; ++i)
+    ti.interrupt_self();
+  auto res = ti.wait_proc(1);
+  BOOST_REQUIRE_EQUAL(res, false);
+}
+
+BOOST_AUTO_TEST_CASE(WaitUntilDeadline)
+{
+  interruptibletest::TestInterruptible ti;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+  auto res = ti.wait_until_proc(deadline);
+
+  BOOST_REQUIRE_EQUAL(res, false);
+  BOOST_REQUIRE(std::chrono::steady_clock::now() >= deadline);
+
+  // A deadline in the past returns immediately
+  BOOST_REQUIRE_EQUAL(ti.wait_until_proc(deadline), false);
+}
+
+BOOST_AUTO_TEST_CASE(WaitAnyTimeout)
+{
+  interruptibletest::TestInterruptible ti;
+  std::atomic<bool> buffer_ready{ false };
+  auto res = ti.wait_any_proc(10, ti.m_wait_condition, buffer_ready, []() { return false; });
+
+  BOOST_REQUIRE(!res.has_value());
+  BOOST_REQUIRE(ti.m_wait_time >= std::chrono::milliseconds(10));
+}
+
+BOOST_AUTO_TEST_CASE(WaitAnyImmediate)
+{
+  interruptibletest::TestInterruptible ti;
+  std::atomic<bool> buffer_ready{ true };
+  auto res = ti.wait_any_proc(10, ti.m_wait_condition, buffer_ready);
+
+  BOOST_REQUIRE(res.has_value());
+  BOOST_REQUIRE_EQUAL(res.value(), 1);
+  BOOST_REQUIRE(ti.m_wait_time < std::chrono::milliseconds(10));
+}
+
+BOOST_AUTO_TEST_CASE(WaitAnyWhichFired)
+{
+  interruptibletest::TestInterruptible ti;
+  std::atomic<bool> buffer_ready{ false };
+  std::atomic<int> items{ 0 };
+  std::optional<size_t> res;
+
+  auto wait_thread = std::thread([&]() {
+    res = ti.wait_any_proc(1000, ti.m_wait_condition, buffer_ready, [&]() { return items.load() >= 3; });
+  });
+  for (int i = 0; i < 3; ++i) {
+    usleep(1000);
+    ++items;
+    ti.interrupt_self();
+  }
+  wait_thread.join();
+
+  BOOST_REQUIRE(res.has_value());
+  BOOST_REQUIRE_EQUAL(res.value(), 2);
+  BOOST_REQUIRE(ti.m_wait_time < std::chrono::milliseconds(1000));
+
+  // The run stopping is reported as the first condition
+  wait_thread = std::thread([&]() { res = ti.wait_any_proc(1000, ti.m_wait_condition, buffer_ready); });
+  usleep(1000);
+  ti.interrupt();
+  wait_thread.join();
+  BOOST_REQUIRE(res.has_value());
+  BOOST_REQUIRE_EQUAL(res.value(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(WaitAnyRuntimeList)
+{
+  interruptibletest::TestInterruptible ti;
+  std::atomic<int> fired{ -1 };
+  std::vector<std::function<bool()>> conditions;
+  for (int i = 0; i < 4; ++i)
+    conditions.push_back([&fired, i]() { return fired.load() == i; });
+
+  std::optional<size_t> res;
+  auto wait_thread = std::thread([&]() {
+    res = ti.wait_any_proc(1000, conditions);
+  });
+  usleep(2000);
+  fired = 3;
+  ti.interrupt_self();
+  wait_thread.join();
+
+  BOOST_REQUIRE(res.has_value());
+  BOOST_REQUIRE_EQUAL(res.value(), 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
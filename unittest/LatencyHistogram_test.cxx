@@ -0,0 +1,136 @@
+/**
+ * @file LatencyHistogram_test.cxx LatencyHistogram class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/LatencyHistogram.hpp"
+
+#define BOOST_TEST_MODULE LatencyHistogram_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogram_test)
+
+namespace {
+// Percentiles are upper bounds, within the bucket resolution
+void
+check_bound(uint64_t value, uint64_t expected)
+{
+  BOOST_REQUIRE(value >= expected);
+  BOOST_REQUIRE(value <= expected + expected / LatencyHistogram::sub_buckets);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Buckets)
+{
+  // Small values are exact
+  for (uint64_t v = 0; v < 2 * LatencyHistogram::sub_buckets; ++v) {
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket(v), v);
+    BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket_upper(v), v);
+  }
+
+  // Every value lies in its bucket, and buckets are contiguous and at most 1/16 of their values wide
+  for (uint64_t v : { uint64_t(33), uint64_t(1000), uint64_t(123456789), uint64_t(1) << 40, (uint64_t(1) << 40) - 1,
+                      std::numeric_limits<uint64_t>::max() }) {
+    auto index = LatencyHistogram::bucket(v);
+    BOOST_REQUIRE(index < LatencyHistogram::n_buckets);
+    BOOST_REQUIRE(v <= LatencyHistogram::bucket_upper(index));
+    BOOST_REQUIRE(v > LatencyHistogram::bucket_upper(index - 1));
+    auto width = LatencyHistogram::bucket_upper(index) - LatencyHistogram::bucket_upper(index - 1);
+    BOOST_REQUIRE(width <= v / LatencyHistogram::sub_buckets + 1);
+  }
+  BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket(std::numeric_limits<uint64_t>::max()), LatencyHistogram::n_buckets - 1);
+  BOOST_REQUIRE_EQUAL(LatencyHistogram::bucket_upper(LatencyHistogram::n_buckets - 1),
+                      std::numeric_limits<uint64_t>::max());
+}
+
+BOOST_AUTO_TEST_CASE(Percentiles)
+{
+  LatencyHistogram histogram;
+  BOOST_REQUIRE_EQUAL(histogram.summary().count, 0);
+  BOOST_REQUIRE_EQUAL(histogram.summary().p99, 0);
+
+  for (uint64_t v = 1; v <= 10000; ++v)
+    histogram.record(v * 1000);
+  auto summary = histogram.summary();
+  BOOST_REQUIRE_EQUAL(summary.count, 10000);
+  BOOST_REQUIRE_EQUAL(summary.max, 10000000);
+  BOOST_REQUIRE_CLOSE(summary.mean, 5000500., 1e-6);
+
+  check_bound(summary.p50, 5000000);
+  check_bound(summary.p90, 9000000);
+  check_bound(summary.p99, 9900000);
+  check_bound(summary.p999, 9990000);
+
+  histogram.record(std::chrono::microseconds(20000));
+  BOOST_REQUIRE_EQUAL(histogram.summary().max, 20000000);
+}
+
+BOOST_AUTO_TEST_CASE(Intervals)
+{
+  LatencyHistogram histogram;
+  for (int i = 0; i < 100; ++i)
+    histogram.record(1000);
+  histogram.record(50000);
+  auto first = histogram.interval_summary();
+  BOOST_REQUIRE_EQUAL(first.count, 101);
+  check_bound(first.p50, 1000);
+  BOOST_REQUIRE_EQUAL(first.max, 50000);
+
+  auto start = histogram.snapshot();
+  for (int i = 0; i < 10; ++i)
+    histogram.record(2000);
+  auto second = histogram.interval_summary();
+  BOOST_REQUIRE_EQUAL(second.count, 10);
+  BOOST_REQUIRE_EQUAL(second.p50, 2000); // capped by the max
+  BOOST_REQUIRE_EQUAL(second.max, 2000);
+  BOOST_REQUIRE_EQUAL(second.mean, 2000.);
+
+  auto since = histogram.summary_since(start);
+  BOOST_REQUIRE_EQUAL(since.count, 10);
+  check_bound(since.max, 2000); // estimated from the buckets
+
+  BOOST_REQUIRE_EQUAL(histogram.interval_summary().count, 0);
+  BOOST_REQUIRE_EQUAL(histogram.summary().count, 111);
+  BOOST_REQUIRE_EQUAL(histogram.summary().max, 50000);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentRecords)
+{
+  LatencyHistogram histogram;
+  constexpr int n_threads = 4;
+  constexpr uint64_t n_records = 100000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&histogram, t]() {
+      for (uint64_t i = 0; i < n_records; ++i)
+        histogram.record(i % 1000 + t);
+    });
+  }
+  uint64_t intervals_count = 0;
+  for (int i = 0; i < 10; ++i) {
+    intervals_count += histogram.interval_summary().count;
+    std::this_thread::yield();
+  }
+  for (auto& thread : threads)
+    thread.join();
+  intervals_count += histogram.interval_summary().count;
+
+  BOOST_REQUIRE_EQUAL(histogram.summary().count, n_threads * n_records);
+  BOOST_REQUIRE_EQUAL(intervals_count, n_threads * n_records);
+  BOOST_REQUIRE_EQUAL(histogram.summary().max, 999 + n_threads - 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,246 @@
+/**
+ * @file ModuleThread_test.cxx ModuleThread class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ModuleThread.hpp"
+
+#include "appfwk/DAQModule.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE ModuleThread_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(ModuleThread_test)
+
+namespace {
+bool
+wait_for(const std::function<bool()>& condition)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+class ThreadModule : public DAQModule
+{
+public:
+  explicit ThreadModule(const std::string& name)
+    : DAQModule(name)
+  {
+    register_command("conf", &ThreadModule::do_conf);
+    register_thread("worker", &ThreadModule::work);
+  }
+
+  void init(std::shared_ptr<ModuleConfiguration>) override {}
+
+  void do_conf(const data_t&) {}
+
+  bool work()
+  {
+    ++iterations;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    return true;
+  }
+
+  std::atomic<uint64_t> iterations{ 0 };
+};
+
+// Registers its thread in init, with the stop command given to the constructor
+class InitThreadModule : public DAQModule
+{
+public:
+  InitThreadModule(const std::string& name, std::string stop_cmd)
+    : DAQModule(name)
+    , stop_cmd(std::move(stop_cmd))
+  {
+  }
+
+  void init(std::shared_ptr<ModuleConfiguration>) override
+  {
+    ++inits;
+    register_thread(
+      "worker",
+      [this, generation = inits.load()]() {
+        last_generation = generation;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        return true;
+      },
+      "start",
+      stop_cmd);
+  }
+
+  std::string stop_cmd;
+  std::atomic<int> inits{ 0 };
+  std::atomic<int> last_generation{ 0 };
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(StartStop)
+{
+  std::atomic<uint64_t> calls{ 0 };
+  ModuleThread thread("test/start_stop", [&]() {
+    ++calls;
+    return true;
+  });
+  BOOST_REQUIRE(!thread.running());
+  thread.stop(); // not started, does nothing
+
+  thread.start();
+  thread.start(); // already started, does nothing
+  BOOST_REQUIRE(wait_for([&]() { return calls.load() > 100; }));
+  BOOST_REQUIRE(thread.running());
+  thread.stop();
+  BOOST_REQUIRE(!thread.running());
+  BOOST_REQUIRE_EQUAL(thread.iterations(), calls.load());
+
+  // Iterations are counted over all the starts
+  auto first_run = thread.iterations();
+  thread.start();
+  BOOST_REQUIRE(wait_for([&]() { return thread.iterations() > first_run; }));
+  thread.stop();
+  BOOST_REQUIRE_EQUAL(thread.iterations(), calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(IterationEnds)
+{
+  int calls = 0;
+  ModuleThread thread("test/ends", [&]() { return ++calls < 10; });
+  thread.start();
+  BOOST_REQUIRE(wait_for([&]() { return !thread.running(); }));
+  BOOST_REQUIRE_EQUAL(thread.iterations(), 10);
+
+  // Can be started again
+  calls = 0;
+  thread.start();
+  BOOST_REQUIRE(wait_for([&]() { return !thread.running(); }));
+  BOOST_REQUIRE_EQUAL(thread.iterations(), 20);
+  thread.stop();
+}
+
+BOOST_AUTO_TEST_CASE(IterationThrows)
+{
+  ModuleThread thread("test/throws", []() -> bool { throw std::runtime_error("test failure"); });
+  thread.start();
+  BOOST_REQUIRE(wait_for([&]() { return !thread.running(); }));
+  thread.stop();
+}
+
+BOOST_AUTO_TEST_CASE(Affinity)
+{
+  std::atomic<int> cpu{ -2 };
+  ModuleThread thread("test/affinity", [&]() {
+    cpu = sched_getcpu();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return true;
+  });
+
+  // Last core the process may run on
+  cpu_set_t allowed;
+  BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int last = CPU_SETSIZE - 1;
+  while (!CPU_ISSET(last, &allowed))
+    --last;
+
+  thread.set_affinity({ last });
+  BOOST_REQUIRE_EQUAL(thread.get_affinity().size(), 1);
+  thread.start();
+  BOOST_REQUIRE(wait_for([&]() { return cpu.load() != -2; }));
+  thread.stop();
+  BOOST_REQUIRE_EQUAL(cpu.load(), last);
+
+  // Invalid cores are reported, the thread still runs
+  thread.set_affinity({ -1 });
+  auto iterations = thread.iterations();
+  thread.start();
+  BOOST_REQUIRE(wait_for([&]() { return thread.iterations() > iterations; }));
+  thread.stop();
+}
+
+BOOST_AUTO_TEST_CASE(DestructorStops)
+{
+  std::atomic<bool> ran{ false };
+  {
+    ModuleThread thread("test/destructor", [&]() {
+      ran = true;
+      return true;
+    });
+    thread.start();
+    BOOST_REQUIRE(wait_for([&]() { return ran.load(); }));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ManagedByModule)
+{
+  ThreadModule module("thread_module");
+  BOOST_REQUIRE(module.has_command("start"));
+  BOOST_REQUIRE(module.has_command("stop"));
+  BOOST_REQUIRE(module.running_threads().empty());
+
+  module.execute_command("conf");
+  module.execute_command("start");
+  BOOST_REQUIRE(wait_for([&]() { return module.iterations.load() > 10; }));
+  BOOST_REQUIRE(module.running_threads() == std::vector<std::string>{ "worker" });
+  module.execute_command("stop");
+  BOOST_REQUIRE(module.running_threads().empty());
+
+  // Threads running before a reconfiguration are started again after it
+  module.execute_command("start");
+  auto running = module.running_threads();
+  module.stop_threads_and_timers();
+  BOOST_REQUIRE(module.running_threads().empty());
+  auto iterations = module.iterations.load();
+  module.execute_command("conf");
+  module.start_threads(running);
+  BOOST_REQUIRE(wait_for([&]() { return module.iterations.load() > iterations; }));
+  BOOST_REQUIRE(module.running_threads() == running);
+  module.stop_threads_and_timers();
+}
+
+BOOST_AUTO_TEST_CASE(RegisteredAgainInInit)
+{
+  InitThreadModule module("init_thread_module", "stop");
+  module.init(nullptr);
+  module.execute_command("start");
+  BOOST_REQUIRE(wait_for([&]() { return module.last_generation.load() == 1; }));
+
+  // Registering again while the thread runs is refused
+  BOOST_REQUIRE_EXCEPTION(
+    module.init(nullptr), ThreadRegistrationFailed, [](ThreadRegistrationFailed) { return true; });
+
+  // Initialised again after its threads were stopped, as for a warm restart: the thread runs the new iteration
+  module.stop_threads_and_timers();
+  module.init(nullptr);
+  BOOST_REQUIRE_EQUAL(module.running_threads().size(), 0);
+  module.execute_command("start");
+  BOOST_REQUIRE(wait_for([&]() { return module.last_generation.load() == 3; }));
+  module.execute_command("stop");
+
+  // The same name with other commands is refused
+  module.stop_cmd = "scrap";
+  BOOST_REQUIRE_EXCEPTION(
+    module.init(nullptr), ThreadRegistrationFailed, [](ThreadRegistrationFailed) { return true; });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+/**
+ * @file OpMonSnapshot_test.cxx OpMonSnapshot class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/OpMonSnapshot.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE OpMonSnapshot_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(OpMonSnapshot_test)
+
+namespace {
+struct Metrics
+{
+  uint64_t messages = 0;
+  uint64_t bytes = 0;
+  double mean_size = 0;
+  uint32_t errors = 0; // makes the struct size not a multiple of the word size
+};
+
+struct Consistent
+{
+  uint64_t values[7];
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(StoreLoad)
+{
+  OpMonSnapshot<Metrics> snapshot;
+  BOOST_REQUIRE_EQUAL(snapshot.version(), 0);
+  BOOST_REQUIRE_EQUAL(snapshot.load().messages, 0);
+
+  snapshot.store(Metrics{ 1, 100, 100., 0 });
+  BOOST_REQUIRE_EQUAL(snapshot.version(), 1);
+  auto metrics = snapshot.load();
+  BOOST_REQUIRE_EQUAL(metrics.messages, 1);
+  BOOST_REQUIRE_EQUAL(metrics.bytes, 100);
+
+  snapshot.update([](Metrics& m) {
+    ++m.messages;
+    m.bytes += 300;
+    m.mean_size = static_cast<double>(m.bytes) / m.messages;
+    ++m.errors;
+  });
+  BOOST_REQUIRE_EQUAL(snapshot.version(), 2);
+  BOOST_REQUIRE_EQUAL(snapshot.writer_view().messages, 2);
+  metrics = snapshot.load();
+  BOOST_REQUIRE_EQUAL(metrics.messages, 2);
+  BOOST_REQUIRE_EQUAL(metrics.bytes, 400);
+  BOOST_REQUIRE_EQUAL(metrics.mean_size, 200.);
+  BOOST_REQUIRE_EQUAL(metrics.errors, 1);
+
+  OpMonSnapshot<Metrics> initialised(Metrics{ 5, 6, 7., 8 });
+  BOOST_REQUIRE_EQUAL(initialised.version(), 0);
+  BOOST_REQUIRE_EQUAL(initialised.load().errors, 8);
+}
+
+// The writer keeps all the fields equal, a reader must never see them differ
+BOOST_AUTO_TEST_CASE(ConcurrentReads)
+{
+  OpMonSnapshot<Consistent> snapshot;
+  std::atomic<bool> done{ false };
+  std::atomic<uint64_t> reads{ 0 }, inconsistent{ 0 };
+
+  std::thread reader([&]() {
+    uint64_t last = 0;
+    while (!done.load()) {
+      auto value = snapshot.load();
+      for (auto v : value.values) {
+        if (v != value.values[0])
+          ++inconsistent;
+      }
+      if (value.values[0] < last)
+        ++inconsistent;
+      last = value.values[0];
+      ++reads;
+    }
+  });
+
+  auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  uint64_t i = 0;
+  while (std::chrono::steady_clock::now() < end || reads.load() < 100) {
+    ++i;
+    snapshot.update([i](Consistent& c) {
+      for (auto& v : c.values)
+        v = i;
+    });
+  }
+  done = true;
+  reader.join();
+
+  BOOST_REQUIRE_EQUAL(inconsistent.load(), 0);
+  BOOST_REQUIRE_EQUAL(snapshot.load().values[6], i);
+  TLOG() << i << " updates, " << reads.load() << " consistent reads";
+}
+
+BOOST_AUTO_TEST_SUITE_END()
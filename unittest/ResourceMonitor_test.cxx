@@ -0,0 +1,104 @@
+/**
+ * @file ResourceMonitor_test.cxx ResourceMonitor class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "ResourceMonitor.hpp"
+
+#define BOOST_TEST_MODULE ResourceMonitor_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(ResourceMonitor_test)
+
+BOOST_AUTO_TEST_CASE(StaticData)
+{
+  ResourceMonitor monitor;
+  char hostname[256];
+  BOOST_REQUIRE_EQUAL(gethostname(hostname, sizeof(hostname)), 0);
+  BOOST_REQUIRE_EQUAL(monitor.hostname(), hostname);
+
+  auto usage = monitor.sample();
+  BOOST_REQUIRE(usage.rss_bytes > 0);
+  BOOST_REQUIRE(usage.vsize_bytes >= usage.rss_bytes);
+  BOOST_REQUIRE(usage.threads >= 1);
+  BOOST_REQUIRE(usage.open_fds >= 3);
+}
+
+BOOST_AUTO_TEST_CASE(MemoryGrowth)
+{
+  ResourceMonitor monitor;
+  monitor.sample();
+
+  constexpr size_t size = 64 << 20;
+  auto block = std::make_unique<char[]>(size);
+  std::memset(block.get(), 1, size); // touch every page
+  auto usage = monitor.sample();
+  BOOST_REQUIRE(usage.rss_growth_bytes >= static_cast<int64_t>(size / 2));
+  BOOST_REQUIRE(usage.minor_faults >= size / 2 / sysconf(_SC_PAGESIZE));
+
+  block.reset();
+  BOOST_REQUIRE(monitor.sample().rss_growth_bytes <= 0);
+}
+
+BOOST_AUTO_TEST_CASE(ThreadsAndFiles)
+{
+  ResourceMonitor monitor;
+  auto before = monitor.sample();
+
+  std::atomic<bool> stop{ false };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i)
+    threads.emplace_back([&stop]() {
+      while (!stop.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+  int fd = open("/dev/null", O_RDONLY);
+  BOOST_REQUIRE(fd >= 0);
+
+  auto during = monitor.sample();
+  stop = true;
+  for (auto& thread : threads)
+    thread.join();
+  close(fd);
+
+  BOOST_REQUIRE_EQUAL(during.threads, before.threads + 3);
+  BOOST_REQUIRE_EQUAL(during.open_fds, before.open_fds + 1);
+  BOOST_REQUIRE(during.voluntary_ctx_switches > before.voluntary_ctx_switches);
+}
+
+BOOST_AUTO_TEST_CASE(CpuUtilisation)
+{
+  ResourceMonitor monitor;
+  monitor.sample();
+
+  // Busy for 200 ms, then idle for 200 ms
+  auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  volatile uint64_t spin = 0;
+  while (std::chrono::steady_clock::now() < end)
+    ++spin;
+  auto busy = monitor.sample();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  auto idle = monitor.sample();
+
+  BOOST_REQUIRE(busy.cpu_utilisation > 0.5);
+  BOOST_REQUIRE(idle.cpu_utilisation < 0.5);
+  BOOST_REQUIRE(idle.user_time_s >= 0.1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+/**
+ * @file ShardedCounter_test.cxx ShardedCounter, ShardedGauge and OpMonCounters Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ShardedCounter.hpp"
+
+#define BOOST_TEST_MODULE ShardedCounter_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(ShardedCounter_test)
+
+BOOST_AUTO_TEST_CASE(Shards)
+{
+  auto shards = detail::default_shards();
+  BOOST_REQUIRE(shards >= 1 && shards <= 64);
+  BOOST_REQUIRE_EQUAL(shards & (shards - 1), 0);
+
+  // Every thread keeps its index, and threads alive at the same time get different ones
+  auto main_index = detail::thread_shard_index();
+  BOOST_REQUIRE_EQUAL(detail::thread_shard_index(), main_index);
+  std::mutex mutex;
+  std::set<size_t> indices{ main_index };
+  std::atomic<int> started{ 0 };
+  std::atomic<bool> exit{ false };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      {
+        const std::lock_guard<std::mutex> lock(mutex);
+        indices.insert(detail::thread_shard_index());
+      }
+      ++started;
+      while (!exit.load())
+        std::this_thread::yield();
+    });
+  }
+  while (started.load() < 4)
+    std::this_thread::yield();
+  BOOST_REQUIRE_EQUAL(indices.size(), 5);
+  BOOST_REQUIRE_EQUAL(*indices.rbegin(), 4);
+  exit = true;
+  for (auto& thread : threads)
+    thread.join();
+
+  // The indices of threads which exited are given to new threads, lowest first
+  size_t reused = 0;
+  std::thread([&reused]() { reused = detail::thread_shard_index(); }).join();
+  indices.erase(main_index);
+  BOOST_REQUIRE_EQUAL(reused, *indices.begin());
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentUpdates)
+{
+  ShardedCounter counter;
+  ShardedGauge gauge;
+  constexpr int n_threads = 8;
+  constexpr uint64_t n_updates = 100000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&]() {
+      for (uint64_t i = 0; i < n_updates; ++i) {
+        counter.increment();
+        gauge.increment(2);
+        gauge.decrement();
+      }
+      counter.increment(10);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_REQUIRE_EQUAL(counter.value(), n_threads * (n_updates + 10));
+  BOOST_REQUIRE_EQUAL(gauge.value(), static_cast<int64_t>(n_threads * n_updates));
+}
+
+BOOST_AUTO_TEST_CASE(NamedMetrics)
+{
+  OpMonCounters counters;
+  auto& received = counters.counter("received");
+  BOOST_REQUIRE_EQUAL(&counters.counter("received"), &received);
+  BOOST_REQUIRE_NE(&counters.counter("sent"), &received);
+
+  received.increment(3);
+  BOOST_REQUIRE_EQUAL(counters.counter("received").value(), 3);
+
+  auto& in_use = counters.gauge("in_use");
+  in_use.decrement(2);
+  BOOST_REQUIRE_EQUAL(counters.gauge("in_use").value(), -2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,258 @@
+/**
+ * @file TimerService_test.cxx TimerService class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/TimerService.hpp"
+
+#include "appfwk/DAQModule.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE TimerService_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(TimerService_test)
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+template<typename Condition>
+bool
+wait_for(Condition&& condition, std::chrono::milliseconds timeout = 5s)
+{
+  auto deadline = clock_type::now() + timeout;
+  while (!condition()) {
+    if (clock_type::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+
+// Schedules a periodic timer on start, and optionally handles scrap
+class TimerModule : public DAQModule
+{
+public:
+  TimerModule(const std::string& name, bool handles_scrap)
+    : DAQModule(name)
+  {
+    register_command("start", &TimerModule::do_start);
+    if (handles_scrap)
+      register_command("scrap", &TimerModule::do_scrap);
+  }
+
+  void init(std::shared_ptr<ModuleConfiguration>) override {}
+
+  void do_start(const data_t&) { timer = schedule_periodic("tick", 5ms, [this]() { ++ticks; }); }
+  void do_scrap(const data_t&) { scrapped_ticks = ticks.load(); }
+  bool cancel() { return cancel_timer(timer); }
+
+  std::atomic<int> ticks{ 0 };
+  int scrapped_ticks{ -1 };
+  TimerService::timer_id_t timer{ 0 };
+};
+
+// Whether the timers of the module stopped firing
+bool
+stopped_ticking(const TimerModule& module)
+{
+  auto ticks = module.ticks.load();
+  std::this_thread::sleep_for(30ms);
+  return module.ticks.load() == ticks;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(OneShot)
+{
+  TimerService service;
+  std::atomic<int> runs{ 0 };
+  clock_type::time_point fired;
+  auto start = clock_type::now();
+  auto id = service.schedule_once("one_shot", 20ms, [&]() {
+    fired = clock_type::now();
+    ++runs;
+  });
+  BOOST_REQUIRE(service.scheduled(id));
+  BOOST_REQUIRE(wait_for([&]() { return !service.scheduled(id); }));
+  BOOST_REQUIRE_EQUAL(runs.load(), 1);
+  BOOST_REQUIRE(fired - start >= 20ms);
+  BOOST_REQUIRE(!service.cancel(id));
+  std::this_thread::sleep_for(30ms);
+  BOOST_REQUIRE_EQUAL(runs.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Periodic)
+{
+  TimerService service;
+  std::atomic<int> runs{ 0 };
+  auto id = service.schedule_periodic("periodic", 5ms, [&]() { ++runs; });
+  BOOST_REQUIRE(wait_for([&]() { return runs.load() >= 10; }));
+  BOOST_REQUIRE(service.cancel(id));
+  auto after_cancel = runs.load();
+  std::this_thread::sleep_for(30ms);
+  BOOST_REQUIRE_EQUAL(runs.load(), after_cancel);
+  BOOST_REQUIRE_EQUAL(service.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(CancelBeforeFiring)
+{
+  TimerService service;
+  std::atomic<bool> ran{ false };
+  auto id = service.schedule_once("cancelled", 50ms, [&]() { ran = true; });
+  BOOST_REQUIRE(service.cancel(id));
+  BOOST_REQUIRE(!service.cancel(id));
+  std::this_thread::sleep_for(100ms);
+  BOOST_REQUIRE(!ran.load());
+}
+
+BOOST_AUTO_TEST_CASE(CancelFromCallback)
+{
+  TimerService service;
+  std::atomic<int> runs{ 0 };
+  auto id = std::make_shared<std::atomic<TimerService::timer_id_t>>(0);
+  *id = service.schedule_periodic("self_cancel", 2ms, [&, id]() {
+    if (++runs == 3)
+      service.cancel(*id);
+  });
+  BOOST_REQUIRE(wait_for([&]() { return !service.scheduled(*id); }));
+  std::this_thread::sleep_for(20ms);
+  BOOST_REQUIRE_EQUAL(runs.load(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(CancelWaitsForCallback)
+{
+  TimerService service;
+  std::atomic<bool> started{ false }, finished{ false };
+  auto id = service.schedule_once("slow", 0ms, [&]() {
+    started = true;
+    std::this_thread::sleep_for(50ms);
+    finished = true;
+  });
+  BOOST_REQUIRE(wait_for([&]() { return started.load(); }));
+  BOOST_REQUIRE(service.cancel(id));
+  BOOST_REQUIRE(finished.load());
+}
+
+BOOST_AUTO_TEST_CASE(Overruns)
+{
+  TimerService service(2);
+  std::atomic<int> concurrent{ 0 }, max_concurrent{ 0 }, runs{ 0 };
+  auto id = service.schedule_periodic("overrun", 1ms, [&]() {
+    max_concurrent = std::max(max_concurrent.load(), ++concurrent);
+    std::this_thread::sleep_for(10ms);
+    --concurrent;
+    ++runs;
+  });
+  BOOST_REQUIRE(wait_for([&]() { return runs.load() >= 5; }));
+  auto stats = service.get_stats();
+  service.cancel(id);
+
+  BOOST_REQUIRE_EQUAL(max_concurrent.load(), 1);
+  BOOST_REQUIRE_EQUAL(stats.size(), 1);
+  BOOST_REQUIRE_EQUAL(stats[0].name, "overrun");
+  BOOST_REQUIRE(stats[0].overruns > 0);
+  BOOST_REQUIRE(stats[0].max_duration_us >= 10000);
+}
+
+BOOST_AUTO_TEST_CASE(FailingCallback)
+{
+  TimerService service;
+  std::atomic<int> runs{ 0 };
+  auto id = service.schedule_periodic("failing", 2ms, [&]() {
+    ++runs;
+    throw std::runtime_error("test failure");
+  });
+  BOOST_REQUIRE(wait_for([&]() { return runs.load() >= 3; }));
+  service.cancel(id);
+}
+
+// Timers spread over the first two levels of the wheel, none may fire early nor be lost
+BOOST_AUTO_TEST_CASE(ManyTimers)
+{
+  TimerService service;
+  constexpr int n_timers = 1000;
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> delay_ms(0, 600);
+
+  std::atomic<int> fired{ 0 }, early{ 0 };
+  auto start = clock_type::now();
+  for (int i = 0; i < n_timers; ++i) {
+    auto delay = std::chrono::milliseconds(delay_ms(random));
+    service.schedule_once("timer_" + std::to_string(i), delay, [&, delay]() {
+      if (clock_type::now() - start < delay)
+        ++early;
+      ++fired;
+    });
+  }
+  BOOST_REQUIRE(wait_for([&]() { return fired.load() == n_timers; }));
+  BOOST_REQUIRE_EQUAL(early.load(), 0);
+  BOOST_REQUIRE_EQUAL(service.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Jitter)
+{
+  TimerService service;
+  std::atomic<int> runs{ 0 };
+  auto id = service.schedule_periodic("jitter", 10ms, [&]() { ++runs; });
+  BOOST_REQUIRE(wait_for([&]() { return runs.load() >= 20; }));
+  auto stats = service.get_stats();
+  service.cancel(id);
+
+  BOOST_REQUIRE_EQUAL(stats.size(), 1);
+  BOOST_REQUIRE(stats[0].runs >= 20);
+  BOOST_REQUIRE(stats[0].max_lateness_us >= stats[0].mean_lateness_us);
+  TLOG() << "Lateness of a 10 ms periodic timer: mean " << stats[0].mean_lateness_us << " us, max "
+         << stats[0].max_lateness_us << " us";
+}
+
+BOOST_AUTO_TEST_CASE(ModuleTimers)
+{
+  // Timers are cancelled before the scrap handler runs
+  TimerModule module("timer_module", true);
+  module.execute_command("start");
+  BOOST_REQUIRE(wait_for([&]() { return module.ticks.load() >= 5; }));
+  BOOST_REQUIRE(get_timer_service()->scheduled(module.timer));
+  module.execute_command("scrap");
+  BOOST_REQUIRE(!get_timer_service()->scheduled(module.timer));
+  BOOST_REQUIRE_EQUAL(module.scrapped_ticks, module.ticks.load());
+  BOOST_REQUIRE(stopped_ticking(module));
+
+  // Cancelled explicitly
+  module.execute_command("start");
+  BOOST_REQUIRE(wait_for([&]() { return module.ticks.load() >= module.scrapped_ticks + 5; }));
+  BOOST_REQUIRE(module.cancel());
+  BOOST_REQUIRE(!module.cancel());
+  BOOST_REQUIRE(stopped_ticking(module));
+}
+
+BOOST_AUTO_TEST_CASE(ModuleTimersWithoutScrap)
+{
+  // The framework cancels the timers of modules which do not handle scrap before releasing them
+  auto module = std::make_shared<TimerModule>("timer_module_no_scrap", false);
+  BOOST_REQUIRE(!module->has_command("scrap"));
+  module->execute_command("start");
+  BOOST_REQUIRE(wait_for([&]() { return module->ticks.load() >= 5; }));
+  module->stop_threads_and_timers();
+  BOOST_REQUIRE(!get_timer_service()->scheduled(module->timer));
+  BOOST_REQUIRE(stopped_ticking(*module));
+  module.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+/**
+ * @file TraceRecorder_test.cxx TraceRecorder class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TraceRecorder.hpp"
+
+#include "appfwk/Issues.hpp"
+
+#define BOOST_TEST_MODULE TraceRecorder_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(TraceRecorder_test)
+
+using namespace dunedaq::appfwk;
+
+namespace {
+
+std::string
+trace_path(const std::string& name)
+{
+  return "/tmp/TraceRecorder_test_" + name + "_" + std::to_string(getpid()) + ".json";
+}
+
+nlohmann::json
+read_trace(const std::string& path)
+{
+  std::ifstream ifs(path);
+  auto j = nlohmann::json::parse(ifs);
+  std::remove(path.c_str());
+  return j;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  TraceRecorder trace;
+  BOOST_REQUIRE(!trace.enabled());
+  trace.record("event", "test", 0, 1000);
+  {
+    TraceRecorder::Scope scope(trace, "scope", "test");
+  }
+  trace.flush();
+}
+
+BOOST_AUTO_TEST_CASE(Events)
+{
+  auto path = trace_path("events");
+  {
+    TraceRecorder trace;
+    trace.open(path, "test_process");
+    BOOST_REQUIRE(trace.enabled());
+    trace.record("event", "test", 1000, 3000, { { "key", "value" } });
+    {
+      TraceRecorder::Scope scope(trace, "scope", "test");
+    }
+    try {
+      TraceRecorder::Scope scope(trace, "failing", "test");
+      throw std::runtime_error("failure");
+    } catch (const std::runtime_error&) {
+    }
+    trace.flush();
+  }
+
+  auto j = read_trace(path);
+  BOOST_REQUIRE(j.is_array());
+  BOOST_REQUIRE_EQUAL(j.size(), 4);
+  BOOST_REQUIRE_EQUAL(j[0]["ph"].get<std::string>(), "M");
+  BOOST_REQUIRE_EQUAL(j[0]["args"]["name"].get<std::string>(), "test_process");
+
+  BOOST_REQUIRE_EQUAL(j[1]["name"].get<std::string>(), "event");
+  BOOST_REQUIRE_EQUAL(j[1]["ph"].get<std::string>(), "X");
+  BOOST_REQUIRE_EQUAL(j[1]["ts"].get<double>(), 1.);
+  BOOST_REQUIRE_EQUAL(j[1]["dur"].get<double>(), 2.);
+  BOOST_REQUIRE_EQUAL(j[1]["pid"].get<int>(), getpid());
+  BOOST_REQUIRE_EQUAL(j[1]["args"]["key"].get<std::string>(), "value");
+
+  BOOST_REQUIRE_EQUAL(j[2]["name"].get<std::string>(), "scope");
+  BOOST_REQUIRE_GE(j[2]["dur"].get<double>(), 0.);
+  BOOST_REQUIRE(!j[2]["args"].contains("failed"));
+  BOOST_REQUIRE_EQUAL(j[3]["name"].get<std::string>(), "failing");
+  BOOST_REQUIRE(j[3]["args"]["failed"].get<bool>());
+}
+
+BOOST_AUTO_TEST_CASE(Threads)
+{
+  auto path = trace_path("threads");
+  {
+    TraceRecorder trace;
+    trace.open(path);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&trace, t]() {
+        trace.name_thread("thread_" + std::to_string(t));
+        for (int i = 0; i < 100; ++i) {
+          TraceRecorder::Scope scope(trace, "work", "test");
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  auto j = read_trace(path);
+  BOOST_REQUIRE_EQUAL(j.size(), 404);
+  std::set<int64_t> tids;
+  for (const auto& event : j) {
+    if (event["ph"] == "X")
+      tids.insert(event["tid"].get<int64_t>());
+  }
+  BOOST_REQUIRE_EQUAL(tids.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(ThreadNamedOnce)
+{
+  auto first_path = trace_path("named_once_first");
+  auto second_path = trace_path("named_once_second");
+  TraceRecorder trace;
+  trace.open(first_path);
+  for (int i = 0; i < 3; ++i)
+    trace.name_thread("worker");
+  trace.name_thread("renamed");
+  trace.open(second_path);
+  trace.name_thread("renamed");
+  trace.close();
+
+  auto first = read_trace(first_path);
+  BOOST_REQUIRE_EQUAL(first.size(), 2);
+  BOOST_REQUIRE_EQUAL(first[0]["args"]["name"].get<std::string>(), "worker");
+  BOOST_REQUIRE_EQUAL(first[1]["args"]["name"].get<std::string>(), "renamed");
+  // A new trace file needs its own thread labels
+  auto second = read_trace(second_path);
+  BOOST_REQUIRE_EQUAL(second.size(), 1);
+  BOOST_REQUIRE_EQUAL(second[0]["args"]["name"].get<std::string>(), "renamed");
+}
+
+BOOST_AUTO_TEST_CASE(ScopeBegunWhileDisabled)
+{
+  auto first_path = trace_path("scope_disabled_first");
+  auto second_path = trace_path("scope_disabled_second");
+  TraceRecorder trace;
+  {
+    TraceRecorder::Scope before_open(trace, "before_open", "test");
+    trace.open(first_path);
+    {
+      TraceRecorder::Scope before_reopen(trace, "before_reopen", "test");
+      trace.open(second_path);
+      TraceRecorder::Scope inside(trace, "inside", "test");
+    }
+  }
+  trace.close();
+
+  BOOST_REQUIRE(read_trace(first_path).empty());
+  auto second = read_trace(second_path);
+  BOOST_REQUIRE_EQUAL(second.size(), 1);
+  BOOST_REQUIRE_EQUAL(second[0]["name"].get<std::string>(), "inside");
+}
+
+BOOST_AUTO_TEST_CASE(BadPath)
+{
+  TraceRecorder trace;
+  BOOST_REQUIRE_EXCEPTION(trace.open("/nonexistent/directory/trace.json"), BadFile, [&](BadFile) { return true; });
+  BOOST_REQUIRE(!trace.enabled());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+/**
+ * @file TscClock_test.cxx TscClock class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/TscClock.hpp"
+
+#include "logging/Logging.hpp"
+
+#define BOOST_TEST_MODULE TscClock_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using namespace dunedaq::appfwk;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(TscClock_test)
+
+namespace {
+int64_t
+steady_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+} // namespace
+
+// First, before any conversion calibrates the clock
+BOOST_AUTO_TEST_CASE(Calibrate)
+{
+  auto start = std::chrono::steady_clock::now();
+  TscClock::calibrate();
+  if (TscClock::uses_tsc())
+    BOOST_REQUIRE(std::chrono::steady_clock::now() - start >= 10ms);
+
+  // The first conversion does not wait for a calibration any more
+  start = std::chrono::steady_clock::now();
+  TscClock::to_ns(TscClock::now());
+  TscClock::calibrate();
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start < 5ms);
+}
+
+BOOST_AUTO_TEST_CASE(Monotonic)
+{
+  TLOG() << "TSC " << (TscClock::uses_tsc() ? "used" : "not used") << ", " << TscClock::ticks_per_ns()
+         << " ticks per ns";
+  auto previous = TscClock::now();
+  for (int i = 0; i < 100000; ++i) {
+    auto now = TscClock::now();
+    BOOST_REQUIRE(now >= previous);
+    previous = now;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Durations)
+{
+  auto start_ticks = TscClock::now();
+  auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(50ms);
+  auto elapsed_ticks = TscClock::now() - start_ticks;
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // Both measurements bracket the same sleep, within the precision of the initial calibration
+  auto difference = TscClock::to_duration(elapsed_ticks) - elapsed;
+  BOOST_REQUIRE(difference < 1ms && difference > -1ms);
+  BOOST_REQUIRE(TscClock::to_duration(elapsed_ticks) >= 50ms - 1ms);
+}
+
+BOOST_AUTO_TEST_CASE(SteadyClockTime)
+{
+  for (int i = 0; i < 3; ++i) {
+    auto before = steady_ns();
+    auto ticks = TscClock::now();
+    auto after = steady_ns();
+    auto converted = TscClock::to_steady_ns(ticks);
+    BOOST_REQUIRE(converted > before - 1000000);
+    BOOST_REQUIRE(converted < after + 1000000);
+    std::this_thread::sleep_for(20ms);
+  }
+
+  // Timestamps taken before the calibration reference point are converted too
+  auto old_ticks = TscClock::now();
+  auto old_ns = steady_ns();
+  std::this_thread::sleep_for(20ms);
+  TscClock::to_steady_ns(TscClock::now());
+  auto converted = TscClock::to_steady_ns(old_ticks);
+  BOOST_REQUIRE(converted > old_ns - 1000000 && converted < old_ns + 1000000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,224 @@
+/**
+ * @file dbConfFacility_test.cxx dbConfFacility response cache Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ConfFacility.hpp"
+
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+#include <pistache/net.h>
+
+#define BOOST_TEST_MODULE dbConfFacility_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace dunedaq::appfwk;
+using namespace Pistache;
+
+BOOST_AUTO_TEST_SUITE(dbConfFacility_test)
+
+namespace {
+
+// What the configuration service answers, and the If-None-Match header of every request it received
+struct ServiceState
+{
+  std::mutex mutex;
+  Http::Code code = Http::Code::Ok;
+  std::string body = R"({"value": 1})";
+  std::string etag = "\"v1\"";
+  std::vector<std::string> if_none_match;
+};
+
+std::string
+header_value(const Http::Header::Collection& headers, const std::string& name)
+{
+  if (auto typed = headers.tryGet(name)) {
+    std::ostringstream os;
+    typed->write(os);
+    return os.str();
+  }
+  for (const auto& [raw_name, raw] : headers.rawList()) {
+    if (std::equal(raw_name.begin(), raw_name.end(), name.begin(), name.end(), [](char a, char b) {
+          return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        }))
+      return raw.value();
+  }
+  return "";
+}
+
+class ServiceHandler : public Http::Handler
+{
+public:
+  HTTP_PROTOTYPE(ServiceHandler)
+
+  explicit ServiceHandler(std::shared_ptr<ServiceState> state)
+    : m_state(std::move(state))
+  {
+  }
+
+  void onRequest(const Http::Request& request, Http::ResponseWriter response) override
+  {
+    const std::lock_guard<std::mutex> lock(m_state->mutex);
+    auto if_none_match = header_value(request.headers(), "If-None-Match");
+    m_state->if_none_match.push_back(if_none_match);
+    if (m_state->code == Http::Code::Ok && !if_none_match.empty() && if_none_match == m_state->etag) {
+      response.send(Http::Code::Not_Modified);
+      return;
+    }
+    response.headers().addRaw(Http::Header::Raw("ETag", m_state->etag));
+    response.send(m_state->code, m_state->body);
+  }
+
+private:
+  std::shared_ptr<ServiceState> m_state;
+};
+
+// A local configuration service and a dbConfFacility using it, with an empty cache directory
+struct ServiceFixture
+{
+  ServiceFixture()
+    : state(std::make_shared<ServiceState>())
+    , endpoint(Address(Ipv4::loopback(), Port(0)))
+    , cache_dir(std::filesystem::temp_directory_path() / ("dbConfFacility_test_" + std::to_string(getpid())))
+  {
+    endpoint.init(Http::Endpoint::options().threads(1));
+    endpoint.setHandler(Http::make_handler<ServiceHandler>(state));
+    endpoint.serveThreaded();
+
+    std::filesystem::remove_all(cache_dir);
+    setenv("DUNEDAQ_CONF_CACHE_DIR", cache_dir.c_str(), 1);
+    setenv("DUNEDAQ_CONF_DB_TIMEOUT_MS", "2000", 1);
+    facility = make_conf_facility("db://127.0.0.1:" + std::to_string(static_cast<uint16_t>(endpoint.getPort())) +
+                                  "/configuration?session=test");
+  }
+
+  ~ServiceFixture()
+  {
+    facility.reset();
+    endpoint.shutdown();
+    std::filesystem::remove_all(cache_dir);
+    unsetenv("DUNEDAQ_CONF_CACHE_DIR");
+  }
+
+  nlohmann::json get() { return facility->get_data("test_app", "conf", ""); }
+
+  void set(Http::Code code, const std::string& body, const std::string& etag)
+  {
+    const std::lock_guard<std::mutex> lock(state->mutex);
+    state->code = code;
+    state->body = body;
+    state->etag = etag;
+  }
+
+  std::vector<std::string> requests()
+  {
+    const std::lock_guard<std::mutex> lock(state->mutex);
+    return state->if_none_match;
+  }
+
+  std::shared_ptr<ServiceState> state;
+  Http::Endpoint endpoint;
+  std::filesystem::path cache_dir;
+  std::shared_ptr<ConfFacility> facility;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(MissThenRevalidated, ServiceFixture)
+{
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+  auto counters = facility->get_cache_counters();
+  BOOST_REQUIRE_EQUAL(counters.misses, 1);
+  BOOST_REQUIRE_EQUAL(counters.revalidations, 0);
+
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+  counters = facility->get_cache_counters();
+  BOOST_REQUIRE_EQUAL(counters.misses, 1);
+  BOOST_REQUIRE_EQUAL(counters.revalidations, 1);
+  BOOST_REQUIRE_EQUAL(counters.hits, 1);
+  BOOST_REQUIRE(requests() == std::vector<std::string>({ "", "\"v1\"" }));
+
+  // A new version is downloaded in full
+  set(Http::Code::Ok, R"({"value": 2})", "\"v2\"");
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 2);
+  BOOST_REQUIRE_EQUAL(facility->get_cache_counters().misses, 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(ErrorStatusServesCache, ServiceFixture)
+{
+  // Without a cached copy, an error status gives no data
+  set(Http::Code::Internal_Server_Error, R"({"error": "unavailable"})", "\"e\"");
+  BOOST_REQUIRE(get().is_null());
+
+  set(Http::Code::Ok, R"({"value": 1})", "\"v1\"");
+  get();
+  set(Http::Code::Internal_Server_Error, R"({"error": "unavailable"})", "\"e\"");
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+  auto counters = facility->get_cache_counters();
+  BOOST_REQUIRE_EQUAL(counters.stale_hits, 1);
+  BOOST_REQUIRE_EQUAL(counters.misses, 1);
+  BOOST_REQUIRE_EQUAL(counters.hits, 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(InvalidBodyServesCache, ServiceFixture)
+{
+  get();
+  set(Http::Code::Ok, "not json", "\"v2\"");
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+  auto counters = facility->get_cache_counters();
+  BOOST_REQUIRE_EQUAL(counters.stale_hits, 1);
+  BOOST_REQUIRE_EQUAL(counters.misses, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(MissingObjectRequestedAgain, ServiceFixture)
+{
+  get();
+  std::filesystem::remove_all(cache_dir / "objects");
+  std::filesystem::create_directories(cache_dir / "objects");
+
+  // The service answers 304 to the conditional request, the facility asks again without If-None-Match
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+  BOOST_REQUIRE(requests() == std::vector<std::string>({ "", "\"v1\"", "" }));
+  auto counters = facility->get_cache_counters();
+  BOOST_REQUIRE_EQUAL(counters.misses, 2);
+  BOOST_REQUIRE_EQUAL(counters.hits, 0);
+
+  // The object is cached again
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+  BOOST_REQUIRE_EQUAL(facility->get_cache_counters().hits, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(ConcurrentRetrievals, ServiceFixture)
+{
+  // The threads of one application store the same cache files at the same time
+  std::vector<std::future<nlohmann::json>> futures;
+  for (int i = 0; i < 8; ++i)
+    futures.push_back(facility->get_data_async("test_app", "conf", ""));
+  for (auto& future : futures)
+    BOOST_REQUIRE_EQUAL(future.get()["value"].get<int>(), 1);
+
+  // Every writer renamed its own temporary file, none is left behind
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(cache_dir)) {
+    if (entry.is_regular_file())
+      BOOST_REQUIRE_EQUAL(entry.path().extension().string(), ".json");
+  }
+  BOOST_REQUIRE_EQUAL(get()["value"].get<int>(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+/**
+ * @file fileConfFacility_test.cxx fileConfFacility asynchronous retrieval and prefetching Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "appfwk/ConfFacility.hpp"
+
+#define BOOST_TEST_MODULE fileConfFacility_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace dunedaq::appfwk;
+
+BOOST_AUTO_TEST_SUITE(fileConfFacility_test)
+
+namespace {
+
+// Two configuration directories, the facility pointing to the first one
+struct DirectoryFixture
+{
+  DirectoryFixture()
+    : base(std::filesystem::temp_directory_path() / ("fileConfFacility_test_" + std::to_string(getpid())))
+    , first(base / "first")
+    , second(base / "second")
+  {
+    std::filesystem::create_directories(first);
+    std::filesystem::create_directories(second);
+    write(first, "conf", 1);
+    write(second, "conf", 2);
+    facility = make_conf_facility("file://" + first.string());
+  }
+
+  ~DirectoryFixture()
+  {
+    facility.reset();
+    std::filesystem::remove_all(base);
+  }
+
+  static void write(const std::filesystem::path& dir, const std::string& cmd, int value)
+  {
+    std::ofstream(dir / ("test_app_" + cmd + ".json")) << "{\"value\": " << value << "}";
+  }
+
+  int value(const std::string& cmd, const std::string& uri = "")
+  {
+    return facility->get_data("test_app", cmd, uri)["value"].get<int>();
+  }
+
+  std::filesystem::path base;
+  std::filesystem::path first;
+  std::filesystem::path second;
+  std::shared_ptr<ConfFacility> facility;
+};
+
+// Prefetches run in the background: give them time to read the files before these are changed
+void
+let_prefetch_complete()
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(GetDataAsync, DirectoryFixture)
+{
+  auto future = facility->get_data_async("test_app", "conf", "");
+  BOOST_REQUIRE_EQUAL(future.get()["value"].get<int>(), 1);
+
+  // An explicit URI is remembered, like for get_data
+  future = facility->get_data_async("test_app", "conf", "file://" + second.string());
+  BOOST_REQUIRE_EQUAL(future.get()["value"].get<int>(), 2);
+  BOOST_REQUIRE_EQUAL(value("conf"), 2);
+
+  BOOST_REQUIRE_THROW(facility->get_data_async("test_app", "missing", "").get(), BadFile);
+}
+
+BOOST_FIXTURE_TEST_CASE(PrefetchedDataTaken, DirectoryFixture)
+{
+  write(first, "start", 10);
+  facility->prefetch("test_app", { "conf", "start" });
+  let_prefetch_complete();
+  write(first, "conf", 3);
+  write(first, "start", 30);
+
+  // The prefetched data is handed over once, whether the URI is given or left empty
+  BOOST_REQUIRE_EQUAL(value("conf"), 1);
+  BOOST_REQUIRE_EQUAL(value("start", "file://" + first.string()), 10);
+  BOOST_REQUIRE_EQUAL(value("conf"), 3);
+  BOOST_REQUIRE_EQUAL(value("start"), 30);
+}
+
+BOOST_FIXTURE_TEST_CASE(PrefetchKeyedOnResolvedUri, DirectoryFixture)
+{
+  facility->prefetch("test_app", { "conf" });
+  let_prefetch_complete();
+
+  // Data prefetched from the first directory is not handed over for the second one, given explicitly or not
+  BOOST_REQUIRE_EQUAL(value("conf", "file://" + second.string()), 2);
+  BOOST_REQUIRE_EQUAL(value("conf"), 2);
+
+  // Data prefetched with an explicit URI is handed over to a request with an empty one resolving to it
+  write(second, "conf", 4);
+  facility->prefetch("test_app", { "conf" }, "file://" + second.string());
+  let_prefetch_complete();
+  write(second, "conf", 5);
+  BOOST_REQUIRE_EQUAL(value("conf"), 4);
+  BOOST_REQUIRE_EQUAL(value("conf"), 5);
+}
+
+BOOST_FIXTURE_TEST_CASE(FailedPrefetchDiscarded, DirectoryFixture)
+{
+  facility->prefetch("test_app", { "late" });
+  let_prefetch_complete();
+  write(first, "late", 6);
+  BOOST_REQUIRE_EQUAL(value("late"), 6);
+}
+
+BOOST_FIXTURE_TEST_CASE(PrefetchExpires, DirectoryFixture)
+{
+  facility->set_prefetch_ttl(std::chrono::milliseconds(500));
+  facility->prefetch("test_app", { "conf" });
+  let_prefetch_complete();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  // An expired prefetch is retrieved again by the next prefetch
+  write(first, "conf", 7);
+  facility->prefetch("test_app", { "conf" });
+  let_prefetch_complete();
+  write(first, "conf", 8);
+  BOOST_REQUIRE_EQUAL(value("conf"), 7);
+
+  // and is not handed over
+  facility->prefetch("test_app", { "conf" });
+  let_prefetch_complete();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  write(first, "conf", 9);
+  BOOST_REQUIRE_EQUAL(value("conf"), 9);
+}
+
+BOOST_FIXTURE_TEST_CASE(PrefetchGenerations, DirectoryFixture)
+{
+  facility->prefetch("test_app", { "conf" });
+  let_prefetch_complete();
+  write(first, "conf", 10);
+  facility->invalidate_prefetched();
+  BOOST_REQUIRE_EQUAL(value("conf"), 10);
+
+  // Prefetches of the new generation are handed over
+  facility->prefetch("test_app", { "conf" });
+  let_prefetch_complete();
+  write(first, "conf", 11);
+  BOOST_REQUIRE_EQUAL(value("conf"), 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()